@@ -0,0 +1,54 @@
+# embed.cmake
+#
+# Created by Amy Parent <amy@amyparent.com>
+# Copyright (c) 2024 Laminar Research
+#
+# Turns the files under ROOT into a C source file (OUTPUT) with one array per file, and a table of
+# them sorted by name (see src/rdr2000/resources.h). Textures converted at build time are picked
+# up from EXTRA, if it's set. Run in script mode:
+#
+#   cmake -DROOT=<dir> [-DEXTRA=<dir>] -DOUTPUT=<file.c> -P embed.cmake
+
+# Must match the files the plugin's CMakeLists.txt depends on. The panel's images and the font are
+# only read through the textures texconv makes of them (the cursors go through the OS, which needs
+# them as files), so only the shaders are embedded as they are.
+set(EMBED_PATTERNS shaders/*)
+
+list(TRANSFORM EMBED_PATTERNS PREPEND "${ROOT}/")
+file(GLOB EMBED_FILES RELATIVE "${ROOT}" LIST_DIRECTORIES false ${EMBED_PATTERNS})
+if(EXTRA)
+    file(GLOB EXTRA_FILES RELATIVE "${EXTRA}" LIST_DIRECTORIES false "${EXTRA}/*.rtex")
+    list(APPEND EMBED_FILES ${EXTRA_FILES})
+endif()
+list(SORT EMBED_FILES)
+
+set(SOURCE "// Generated from ${ROOT} by embed.cmake, do not edit.\n")
+string(APPEND SOURCE "#include \"resources.h\"\n\n")
+
+set(TABLE "")
+set(INDEX 0)
+foreach(NAME ${EMBED_FILES})
+    if(EXTRA AND EXISTS "${EXTRA}/${NAME}")
+        file(READ "${EXTRA}/${NAME}" HEX HEX)
+    else()
+        file(READ "${ROOT}/${NAME}" HEX HEX)
+    endif()
+    string(LENGTH "${HEX}" SIZE)
+    math(EXPR SIZE "${SIZE} / 2")
+    string(REGEX REPLACE "([0-9a-f][0-9a-f])" "0x\\1," HEX "${HEX}")
+    string(REGEX REPLACE "((0x..,){32})" "\\1\n    " HEX "${HEX}")
+    
+    # The extra NUL means text resources can be used as C strings.
+    string(APPEND SOURCE "static const uint8_t res_${INDEX}[] = {\n    ${HEX}0x00\n};\n\n")
+    string(APPEND TABLE "    {\"${NAME}\", res_${INDEX}, ${SIZE}},\n")
+    math(EXPR INDEX "${INDEX} + 1")
+endforeach()
+
+string(APPEND SOURCE "const resource_t resources[] = {\n${TABLE}};\n\n")
+string(APPEND SOURCE "const unsigned resource_count = ${INDEX};\n")
+
+# Only touch the output when it changes, so the plugin isn't rebuilt for nothing.
+set(TMP "${OUTPUT}.tmp")
+file(WRITE "${TMP}" "${SOURCE}")
+configure_file("${TMP}" "${OUTPUT}" COPYONLY)
+file(REMOVE "${TMP}")
@@ -3,8 +3,20 @@
 layout(location=0)      uniform sampler2D   tex;
 layout(location=1)      uniform sampler2D   mask;
 layout(location=2)      uniform float       alpha;
-layout(location=3)      uniform float       scale;
-layout(location=4)      uniform float       blink;
+layout(location=3)      uniform vec4        mask_rect;
+
+// Per-frame parameters shared by every radar pass, mirrored by rds_params_t.
+layout(std140, binding = 0) uniform rds_params {
+    vec2    aspect;
+    float   polar_lim;
+    float   polar_dist;
+    float   buf_h;
+    float   range;
+    float   gain;
+    float   ant_offset;
+    float   blink;
+    float   scale;
+} params;
 
 layout(location = 0)    in vec2             tex_coord;
 layout(location = 0)    out vec4            out_color;
@@ -14,13 +26,14 @@ const vec4 glow = vec4(0.12, 0.15, 0.2, 1.0);
 const vec3 magenta = vec3(1, 0, 1);
 
 void main() {
-    vec2 uv = vec2((tex_coord.x / scale) - 0.5 * (1.0/scale - 1.0), tex_coord.y/scale);
+    vec2 uv = vec2((tex_coord.x / params.scale) - 0.5 * (1.0/params.scale - 1.0), tex_coord.y/params.scale);
     vec4 wxr_col = texture(tex, uv);
 
     float dist_from_magenta = distance(magenta, wxr_col.rgb);
-    float t = clamp(step(0.2, dist_from_magenta) + blink, 0, 1);
+    float t = clamp(step(0.2, dist_from_magenta) + params.blink, 0, 1);
     
     vec4 col = glow + t * wxr_col;
-    vec4 mask_brt = texture(mask, tex_coord);
+    // The mask is one image in a texture atlas, at mask_rect.
+    vec4 mask_brt = texture(mask, mask_rect.xy + tex_coord * mask_rect.zw);
     out_color = col * pow(mask_brt.r, 1.5) * mask_brt.a * alpha;
 }
\ No newline at end of file
@@ -1,13 +1,20 @@
 #version 460
 
 layout(location = 0)    uniform sampler2D   tex;
-layout(location = 1)    uniform vec2        aspect;
-layout(location = 3)    uniform float       ant_lim;
-layout(location = 4)    uniform float       ant_offset;
-layout(location = 5)    uniform float       angle_start;
-layout(location = 6)    uniform float       angle_end;
-layout(location = 7)    uniform float       range;
-layout(location = 8)    uniform float       gain;
+layout(location = 3)    uniform sampler2D   atten;
+
+// Per-frame parameters shared by every radar pass, mirrored by rds_params_t.
+layout(std140, binding = 0) uniform rds_params {
+    vec2    aspect;
+    float   polar_lim;
+    float   polar_dist;
+    float   buf_h;
+    float   range;
+    float   gain;
+    float   ant_offset;
+    float   blink;
+    float   scale;
+} params;
 
 layout(location = 0)    in vec2             tex_coord;
 layout(location = 0)    out vec4            out_color;
@@ -26,10 +33,6 @@ vec4 map_color(float W) {
     return colors[clamp(int(W), 0, 4)];
 }
 
-vec2 beam_uv(vec2 beam) {
-    return vec2(0.5, 0) + beam / aspect;
-}
-
 float random2(vec2 st) {
     return fract(sin(dot(st.xy, vec2(12.9898,78.233)))* 43758.5453123);
 }
@@ -42,31 +45,25 @@ float rand_noise(float beam_dist) {
     return beam_dist * 0.05 * random2(tex_coord * 0.01);
 }
 
-vec2 rotate_beam(vec2 beam, float angle) {
-    float cos_ang = cos(angle);
-    float sin_ang = sin(angle);
-    mat2 rot_ang = mat2(cos_ang, -sin_ang, sin_ang, cos_ang);
-    return rot_ang * beam;
+// Everything below works on the polar returns buffer: x is the azimuth, y the range. Rotating the
+// beam is a shift along x, and the path to a return is the column below it.
+vec2 rotate_beam(vec2 coord, float angle) {
+    return vec2(coord.x + angle / (2 * params.polar_lim), coord.y);
 }
 
 #define ATTEN_N 40
 
-float attenuation(vec2 beam) {
-    float integ = 0;
-    float dist = range * length(beam);
-    
-    int n = int((dist/120.f) * ATTEN_N);
-    
-    for(int i = 0; i < n; ++i) {
-        float mult = float(i)/float(n);
-        integ += (2.f-gain) * pow(texture(tex, beam_uv(beam * mult)).r / float(ATTEN_N), 1.25);
-        if(mult * range > dist)
-            break;
-    }
-    return 2 * integ;
+// The attenuation pass stores the integral along each column, so this is a single lookup. The ray
+// march this replaces took one sample every 120/ATTEN_N nm, and stopped at `beam_dist` of the way
+// along the beam: both are folded in here.
+float attenuation(vec2 coord) {
+    float beam_dist = coord.y * params.polar_dist;
+    float path = beam_dist * min(beam_dist, 1);
+    float integ = texture(atten, vec2(coord.x, path / params.polar_dist)).r;
+    return 2 * (2.f-params.gain) * integ * params.range * ATTEN_N / 120.f;
 }
 
-float sample_radar(vec2 beam, float dist) {
+float sample_radar(vec2 coord, float dist) {
     float s1 = sin(dist/2.5 * 16.1803);
     float s2 = sin(dist/2.5 * 95.828);
     float s3 = sin(dist/2.5 * 181.959);
@@ -75,21 +72,13 @@ float sample_radar(vec2 beam, float dist) {
     
     float smear_s = (5 * s1 * s2 * s3 * s4 * s5);
     
-    vec2 uv = beam_uv(rotate_beam(beam, radians(0.2 * ant_offset + smear_s)));
+    vec2 uv = rotate_beam(coord, radians(0.2 * params.ant_offset + smear_s));
     return 0.1 * random2(uv) + texture(tex, uv).r;
 }
 
 void main() {
-    const vec2 up = vec2(0, 1);
-    vec2 beam = (tex_coord - vec2(0.5, 0)) * aspect;
-    float beam_dist = length(beam);
-    float beam_angle = acos(dot(normalize(beam), up));
-    // if(beam_angle > ant_lim || beam_dist > 0.99) discard;
-    beam_angle *= sign(beam.x);
-    if(beam_angle < angle_start || beam_angle > angle_end) discard;
-    
-    out_color = map_color(texture(tex, tex_coord).r);
-    float r = attenuation(beam);
-    float W = mix(sample_radar(beam, beam_dist), abs(rand_noise(beam_dist)), 2*r);
+    float beam_dist = tex_coord.y * params.polar_dist;
+    float r = attenuation(tex_coord);
+    float W = mix(sample_radar(tex_coord, beam_dist), abs(rand_noise(beam_dist)), 2*r);
     out_color = map_color(W);
 }
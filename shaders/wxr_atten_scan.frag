@@ -0,0 +1,40 @@
+#version 460
+
+layout(location = 0)    uniform sampler2D   tex;
+layout(location = 3)    uniform float       stride;
+
+// Per-frame parameters shared by every radar pass, mirrored by rds_params_t.
+layout(std140, binding = 0) uniform rds_params {
+    vec2    aspect;
+    float   polar_lim;
+    float   polar_dist;
+    float   buf_h;
+    float   range;
+    float   gain;
+    float   ant_offset;
+    float   blink;
+    float   scale;
+} params;
+
+layout(location = 0)    in vec2             tex_coord;
+layout(location = 0)    out vec4            out_color;
+
+#define ATTEN_N 40
+
+// Fallback for the attenuation compute shader: a Hillis-Steele scan along each column, ping-ponged
+// between two buffers. The first pass (stride 0) reads the polar returns and shifts them up one
+// row, each following pass adds the value `stride` rows below.
+void main() {
+    float below = tex_coord.y - max(stride, 1) / params.buf_h;
+    float integ = 0;
+    
+    if(stride == 0) {
+        if(below > 0)
+            integ = pow(texture(tex, vec2(tex_coord.x, below)).r / float(ATTEN_N), 1.25) * params.polar_dist / params.buf_h;
+    } else {
+        integ = texture(tex, tex_coord).r;
+        if(below > 0)
+            integ += texture(tex, vec2(tex_coord.x, below)).r;
+    }
+    out_color = vec4(integ, 0, 0, 1);
+}
@@ -0,0 +1,33 @@
+#version 460
+
+layout(location = 0)    uniform sampler2D   tex;
+
+// Per-frame parameters shared by every radar pass, mirrored by rds_params_t.
+layout(std140, binding = 0) uniform rds_params {
+    vec2    aspect;
+    float   polar_lim;
+    float   polar_dist;
+    float   buf_h;
+    float   range;
+    float   gain;
+    float   ant_offset;
+    float   blink;
+    float   scale;
+} params;
+
+layout(location = 0)    in vec2             tex_coord;
+layout(location = 0)    out vec4            out_color;
+
+// Resamples X-Plane's radar texture into the polar returns buffer: one column per azimuth bin
+// (-polar_lim to +polar_lim), one row per range bin (0 to polar_dist).
+void main() {
+    float angle = (2 * tex_coord.x - 1) * params.polar_lim;
+    float dist = tex_coord.y * params.polar_dist;
+    vec2 uv = vec2(0.5, 0) + dist * vec2(sin(angle), cos(angle)) / params.aspect;
+    
+    if(any(lessThan(uv, vec2(0))) || any(greaterThan(uv, vec2(1)))) {
+        out_color = vec4(0, 0, 0, 1);
+    } else {
+        out_color = vec4(texture(tex, uv).r, 0, 0, 1);
+    }
+}
@@ -0,0 +1,29 @@
+#version 460
+
+layout(location = 0)    uniform sampler2D   tex;
+
+// Per-frame parameters shared by every radar pass, mirrored by rds_params_t.
+layout(std140, binding = 0) uniform rds_params {
+    vec2    aspect;
+    float   polar_lim;
+    float   polar_dist;
+    float   buf_h;
+    float   range;
+    float   gain;
+    float   ant_offset;
+    float   blink;
+    float   scale;
+} params;
+
+layout(location = 0)    in vec2             tex_coord;
+layout(location = 0)    out vec4            out_color;
+
+// Scan-converts the polar picture built by the antenna pass back into the cartesian display buffer.
+// Only drawn over the sector swept this frame, so there is no need to test the angle here.
+void main() {
+    vec2 beam = (tex_coord - vec2(0.5, 0)) * params.aspect;
+    float beam_angle = atan(beam.x, beam.y);
+    
+    vec2 polar_uv = vec2(0.5 + 0.5 * beam_angle / params.polar_lim, length(beam) / params.polar_dist);
+    out_color = texture(tex, polar_uv);
+}
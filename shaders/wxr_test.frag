@@ -1,11 +1,17 @@
 #version 460
 
-layout(location = 0)    uniform sampler2D   tex;
-layout(location = 1)    uniform vec2        aspect;
-layout(location = 3)    uniform float       ant_lim;
-layout(location = 4)    uniform float       angle_start;
-layout(location = 5)    uniform float       angle_end;
-layout(location = 6)    uniform float       range;
+// Per-frame parameters shared by every radar pass, mirrored by rds_params_t.
+layout(std140, binding = 0) uniform rds_params {
+    vec2    aspect;
+    float   polar_lim;
+    float   polar_dist;
+    float   buf_h;
+    float   range;
+    float   gain;
+    float   ant_offset;
+    float   blink;
+    float   scale;
+} params;
 
 layout(location = 0)    in vec2             tex_coord;
 layout(location = 0)    out vec4            out_color;
@@ -20,12 +26,10 @@ layout(location = 0)    out vec4            out_color;
 vec4 colors[5] = { TRANS, GREEN, YELLOW, RED, MAGENTA };
 
 void main() {
-    const vec2 up = vec2(0, 1);
-    vec2 beam = (tex_coord - vec2(0.5, 0)) * aspect;
-    float beam_dist = length(beam);
-    float beam_angle = acos(dot(normalize(beam), up));
-    if(beam_angle > ant_lim || beam_dist > 0.62) discard;
-    beam_angle *= sign(beam.x);
-    if(beam_angle < angle_start || beam_angle > angle_end) discard;
+    float beam_dist = tex_coord.y * params.polar_dist;
+    if(beam_dist > 0.62) {
+        out_color = TRANS;
+        return;
+    }
     out_color = colors[clamp(int(beam_dist * 5 / 0.62), 0, 4)];
 }
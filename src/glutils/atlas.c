@@ -0,0 +1,200 @@
+/*===--------------------------------------------------------------------------------------------===
+ * atlas.c
+ *
+ * Created by Amy Parent <amy@amyparent.com>
+ * Copyright (c) 2024 Laminar Research. All rights reserved
+ *
+ * Licensed under the MIT License
+ *===--------------------------------------------------------------------------------------------===
+*/
+#include <glutils/atlas.h>
+#include <glutils/pack.h>
+#include <glutils/stb_image.h>
+#include <helpers/helpers.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct {
+    char        *path;
+    pack_img_t  img;
+} atlas_img_t;
+
+struct gl_atlas_t {
+    unsigned    width;
+    unsigned    height;
+    unsigned    padding;
+    GLuint      tex;
+
+    unsigned    count;
+    unsigned    capacity;
+    atlas_img_t *images;
+};
+
+gl_atlas_t *atlas_new(unsigned width, unsigned padding) {
+    ASSERT(width > 0);
+    gl_atlas_t *atlas = safe_calloc(1, sizeof(*atlas));
+    atlas->width = width;
+    atlas->padding = padding;
+    return atlas;
+}
+
+void atlas_destroy(gl_atlas_t *atlas) {
+    ASSERT(atlas);
+    for(unsigned i = 0; i < atlas->count; ++i) {
+        free(atlas->images[i].path);
+        free(atlas->images[i].img.data);
+    }
+    if(atlas->tex)
+        glDeleteTextures(1, &atlas->tex);
+    free(atlas->images);
+    free(atlas);
+}
+
+int atlas_find_image(const gl_atlas_t *atlas, const char *key) {
+    ASSERT(atlas);
+    ASSERT(key);
+    for(unsigned i = 0; i < atlas->count; ++i) {
+        if(!strcmp(atlas->images[i].path, key))
+            return i;
+    }
+    return -1;
+}
+
+static atlas_img_t *atlas_push(gl_atlas_t *atlas, const char *key) {
+    if(atlas->count == atlas->capacity) {
+        atlas->capacity = atlas->capacity ? atlas->capacity * 2 : 8;
+        atlas->images = safe_realloc(atlas->images, atlas->capacity * sizeof(*atlas->images));
+    }
+    atlas_img_t *img = &atlas->images[atlas->count++];
+    memset(img, 0, sizeof(*img));
+    img->path = safe_strdup(key);
+    return img;
+}
+
+int atlas_add_file(gl_atlas_t *atlas, const char *path) {
+    ASSERT(atlas);
+    ASSERT(path);
+    ASSERT(!atlas->tex);
+
+    int idx = atlas_find_image(atlas, path);
+    if(idx >= 0)
+        return atlas->images[idx].img.data ? idx : -1;
+
+    int w = 0, h = 0, components = 0;
+    uint8_t *data = stbi_load(path, &w, &h, &components, 4);
+    if(!data) {
+        log_msg("unable to load image `%s`", path);
+    } else if(components != 4) {
+        log_msg("image `%s` does not have the right format", path);
+        free(data);
+        data = NULL;
+    }
+    return atlas_add_image(atlas, path, data, w, h);
+}
+
+int atlas_add_image(gl_atlas_t *atlas, const char *key, uint8_t *data, unsigned w, unsigned h) {
+    ASSERT(atlas);
+    ASSERT(key);
+    ASSERT(!atlas->tex);
+
+    int idx = atlas_find_image(atlas, key);
+    if(idx >= 0) {
+        free(data);
+        return atlas->images[idx].img.data ? idx : -1;
+    }
+
+    // Failed images are kept too, so that we don't try to decode them again.
+    atlas_img_t *img = atlas_push(atlas, key);
+    img->img.data = data;
+    img->img.w = data ? w : 0;
+    img->img.h = data ? h : 0;
+    return data ? (int)(atlas->count - 1) : -1;
+}
+
+GLuint atlas_build(gl_atlas_t *atlas) {
+    ASSERT(atlas);
+    ASSERT(!atlas->tex);
+
+    pack_img_t *images = safe_calloc(MAX(atlas->count, 1), sizeof(*images));
+    for(unsigned i = 0; i < atlas->count; ++i)
+        images[i] = atlas->images[i].img;
+    atlas->height = pack_images(images, atlas->count, &atlas->width, atlas->padding, 1);
+    if(!atlas->height) {
+        free(images);
+        log_msg("texture atlas is empty");
+        return 0;
+    }
+
+    unsigned packed = 0;
+    uint8_t *pixels = safe_calloc(atlas->width * atlas->height, 4);
+    for(unsigned i = 0; i < atlas->count; ++i) {
+        atlas_img_t *img = &atlas->images[i];
+        if(!img->img.data)
+            continue;
+        img->img.x = images[i].x;
+        img->img.y = images[i].y;
+        pack_blit(pixels, atlas->width, &img->img, atlas->padding);
+        free(img->img.data);
+        img->img.data = NULL;
+        packed += 1;
+    }
+    free(images);
+
+    atlas->tex = gl_tex_new(atlas->width, atlas->height);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, atlas->width, atlas->height, GL_RGBA,
+                    GL_UNSIGNED_BYTE, pixels);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    free(pixels);
+    CHECK_GL();
+
+    log_msg("packed %u images in a %ux%u texture atlas", packed, atlas->width, atlas->height);
+    return atlas->tex;
+}
+
+GLuint atlas_load(gl_atlas_t *atlas, const uint8_t *data, size_t size) {
+    ASSERT(atlas);
+    ASSERT(!atlas->tex);
+    ASSERT(!atlas->count);
+
+    texfile_t file;
+    if(!texfile_parse(data, size, &file)) {
+        log_msg("invalid texture atlas file");
+        return 0;
+    }
+
+    atlas->width = file.width;
+    atlas->height = file.height;
+    for(unsigned i = 0; i < file.rect_count; ++i) {
+        texfile_rect_t rect;
+        texfile_get_rect(&file, i, &rect);
+        atlas_img_t *img = atlas_push(atlas, rect.name);
+        img->img = (pack_img_t){.x = rect.x, .y = rect.y, .w = rect.w, .h = rect.h};
+    }
+
+    atlas->tex = gl_tex_new_texfile(&file);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    CHECK_GL();
+    return atlas->tex;
+}
+
+GLuint atlas_tex(const gl_atlas_t *atlas) {
+    ASSERT(atlas);
+    return atlas->tex;
+}
+
+void atlas_get_uv(const gl_atlas_t *atlas, int idx, vec4 uv) {
+    ASSERT(atlas);
+    if(idx < 0 || (unsigned)idx >= atlas->count || !atlas->height) {
+        glm_vec4_zero(uv);
+        return;
+    }
+
+    const pack_img_t *img = &atlas->images[idx].img;
+    uv[0] = (float)img->x / (float)atlas->width;
+    uv[1] = (float)img->y / (float)atlas->height;
+    uv[2] = (float)img->w / (float)atlas->width;
+    uv[3] = (float)img->h / (float)atlas->height;
+}
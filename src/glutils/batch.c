@@ -0,0 +1,254 @@
+/*===--------------------------------------------------------------------------------------------===
+ * batch.c
+ *
+ * Created by Amy Parent <amy@amyparent.com>
+ * Copyright (c) 2024 Laminar Research. All rights reserved
+ *
+ * Licensed under the MIT License
+ *===--------------------------------------------------------------------------------------------===
+*/
+#include <glutils/batch.h>
+#include <helpers/helpers.h>
+#include <XPLMGraphics.h>
+#include <stddef.h>
+
+static const char *vert_shader =
+    "#version 120\n"
+    "uniform mat4       pv;\n"
+    "attribute vec2     vtx_corner;\n"
+    "attribute vec4     inst_rect;\n"
+    "attribute vec4     inst_uv;\n"
+    "attribute float    inst_rot;\n"
+    "attribute vec4     inst_color;\n"
+    "varying vec2       tex_coord;\n"
+    "varying vec4       color;\n"
+    "void main() {\n"
+    "   vec2 half_size = 0.5 * inst_rect.zw;\n"
+    "   vec2 p = vtx_corner * inst_rect.zw - half_size;\n"
+    "   float c = cos(inst_rot);\n"
+    "   float s = sin(inst_rot);\n"
+    "   p = vec2(c * p.x - s * p.y, s * p.x + c * p.y);\n"
+    "   tex_coord = inst_uv.xy + vtx_corner * inst_uv.zw;\n"
+    "   color = inst_color;\n"
+    "   gl_Position = pv * vec4(inst_rect.xy + half_size + p, 0.0, 1.0);\n"
+    "}\n";
+
+static const char *frag_shader =
+    "#version 120\n"
+    "uniform sampler2D  tex;\n"
+    "varying vec2       tex_coord;\n"
+    "varying vec4       color;\n"
+    "void main() {\n"
+    "   gl_FragColor = color * texture2D(tex, tex_coord);\n"
+    "}\n";
+
+typedef struct {
+    float   rect[4];
+    float   uv[4];
+    float   rot;
+    float   color[4];
+} sprite_t;
+
+struct gl_batch_t {
+    GLuint      shader;
+    GLuint      vao;
+    GLuint      corner_vbo;
+    GLuint      sprite_vbo;
+    bool        instanced;
+
+    struct {
+        int     pv;
+        int     tex;
+        int     corner;
+        int     rect;
+        int     uv;
+        int     rot;
+        int     color;
+    } loc;
+
+    unsigned    capacity;
+    unsigned    count;
+    sprite_t    *sprites;
+    GLuint      *tex;
+    mat4        pvm;
+    vec4        color;
+};
+
+static void batch_setup_corner(gl_batch_t *batch) {
+    glBindBuffer(GL_ARRAY_BUFFER, batch->corner_vbo);
+    glEnableVertexAttribArray(batch->loc.corner);
+    glVertexAttribPointer(batch->loc.corner, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), 0);
+}
+
+// Points the per-sprite attributes at the sprites starting at `first` in the sprite buffer.
+static void batch_setup_sprites(gl_batch_t *batch, unsigned first) {
+    size_t base = first * sizeof(sprite_t);
+    glBindBuffer(GL_ARRAY_BUFFER, batch->sprite_vbo);
+    glVertexAttribPointer(batch->loc.rect, 4, GL_FLOAT, GL_FALSE, sizeof(sprite_t), (void *)(base + offsetof(sprite_t, rect)));
+    glVertexAttribPointer(batch->loc.uv, 4, GL_FLOAT, GL_FALSE, sizeof(sprite_t), (void *)(base + offsetof(sprite_t, uv)));
+    glVertexAttribPointer(batch->loc.rot, 1, GL_FLOAT, GL_FALSE, sizeof(sprite_t), (void *)(base + offsetof(sprite_t, rot)));
+    glVertexAttribPointer(batch->loc.color, 4, GL_FLOAT, GL_FALSE, sizeof(sprite_t), (void *)(base + offsetof(sprite_t, color)));
+}
+
+gl_batch_t *batch_new(unsigned capacity) {
+    ASSERT(capacity > 0);
+    gl_batch_t *batch = safe_calloc(1, sizeof(*batch));
+    batch->capacity = capacity;
+    batch->sprites = safe_calloc(capacity, sizeof(*batch->sprites));
+    batch->tex = safe_calloc(capacity, sizeof(*batch->tex));
+
+    // Attribute 0 must be an array in compatibility contexts, so we pin the corner there and
+    // re-link. Instancing needs GL 3.3 (which also gives us vertex array objects).
+    batch->instanced = GLEW_VERSION_3_3;
+    batch->shader = gl_program_new(vert_shader, frag_shader);
+    if(batch->shader) {
+        glBindAttribLocation(batch->shader, 0, "vtx_corner");
+        if(!gl_program_relink(batch->shader)) {
+            gl_delete_program(batch->shader);
+            batch->shader = 0;
+        }
+    }
+    // Without a program, the batch has nothing to draw with, and ignores the sprites it's given.
+    if(!batch->shader)
+        return batch;
+
+    batch->loc.pv = glGetUniformLocation(batch->shader, "pv");
+    batch->loc.tex = glGetUniformLocation(batch->shader, "tex");
+    batch->loc.corner = glGetAttribLocation(batch->shader, "vtx_corner");
+    batch->loc.rect = glGetAttribLocation(batch->shader, "inst_rect");
+    batch->loc.uv = glGetAttribLocation(batch->shader, "inst_uv");
+    batch->loc.rot = glGetAttribLocation(batch->shader, "inst_rot");
+    batch->loc.color = glGetAttribLocation(batch->shader, "inst_color");
+
+    gl_use_program(batch->shader);
+    glUniform1i(batch->loc.tex, 0);
+
+    static const float corners[] = {0, 0, 1, 0, 0, 1, 1, 1};
+    glGenBuffers(1, &batch->corner_vbo);
+    glBindBuffer(GL_ARRAY_BUFFER, batch->corner_vbo);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(corners), corners, GL_STATIC_DRAW);
+
+    if(batch->instanced) {
+        glGenBuffers(1, &batch->sprite_vbo);
+        glBindBuffer(GL_ARRAY_BUFFER, batch->sprite_vbo);
+        glBufferData(GL_ARRAY_BUFFER, capacity * sizeof(sprite_t), NULL, GL_STREAM_DRAW);
+
+        glGenVertexArrays(1, &batch->vao);
+        gl_bind_vao(batch->vao);
+        batch_setup_corner(batch);
+        glEnableVertexAttribArray(batch->loc.rect);
+        glEnableVertexAttribArray(batch->loc.uv);
+        glEnableVertexAttribArray(batch->loc.rot);
+        glEnableVertexAttribArray(batch->loc.color);
+        glVertexAttribDivisor(batch->loc.rect, 1);
+        glVertexAttribDivisor(batch->loc.uv, 1);
+        glVertexAttribDivisor(batch->loc.rot, 1);
+        glVertexAttribDivisor(batch->loc.color, 1);
+        batch_setup_sprites(batch, 0);
+        gl_bind_vao(0);
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    CHECK_GL();
+    return batch;
+}
+
+void batch_destroy(gl_batch_t *batch) {
+    ASSERT(batch);
+    if(batch->vao) {
+        gl_bind_vao(0);
+        glDeleteVertexArrays(1, &batch->vao);
+    }
+    glDeleteBuffers(1, &batch->corner_vbo);
+    if(batch->sprite_vbo)
+        glDeleteBuffers(1, &batch->sprite_vbo);
+    gl_delete_program(batch->shader);
+    free(batch->sprites);
+    free(batch->tex);
+    free(batch);
+}
+
+void batch_begin(gl_batch_t *batch, mat4 pvm) {
+    ASSERT(batch);
+    batch->count = 0;
+    glm_mat4_copy(pvm, batch->pvm);
+    glm_vec4_one(batch->color);
+}
+
+void batch_set_color(gl_batch_t *batch, const vec4 color) {
+    ASSERT(batch);
+    memcpy(batch->color, color, sizeof(batch->color));
+}
+
+void batch_add(gl_batch_t *batch, unsigned tex, vec2 pos, vec2 size, float rot, const vec4 uv) {
+    ASSERT(batch);
+    if(!batch->shader)
+        return;
+    if(batch->count >= batch->capacity) {
+        log_msg("sprite batch full (%u sprites)", batch->capacity);
+        return;
+    }
+
+    sprite_t *sprite = &batch->sprites[batch->count];
+    sprite->rect[0] = pos[0];
+    sprite->rect[1] = pos[1];
+    sprite->rect[2] = size[0];
+    sprite->rect[3] = size[1];
+    memcpy(sprite->uv, uv, sizeof(sprite->uv));
+    sprite->rot = glm_rad(rot);
+    memcpy(sprite->color, batch->color, sizeof(sprite->color));
+    batch->tex[batch->count] = tex;
+    batch->count += 1;
+}
+
+// Without instancing, each sprite's attributes are set as constant vertex attributes, and it gets
+// its own (tiny) draw call. Binds still only happen once per run.
+static void batch_draw_run(gl_batch_t *batch, unsigned first, unsigned count) {
+    if(batch->instanced) {
+        batch_setup_sprites(batch, first);
+        glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, count);
+        return;
+    }
+
+    for(unsigned i = first; i < first + count; ++i) {
+        const sprite_t *sprite = &batch->sprites[i];
+        glVertexAttrib4fv(batch->loc.rect, sprite->rect);
+        glVertexAttrib4fv(batch->loc.uv, sprite->uv);
+        glVertexAttrib1f(batch->loc.rot, sprite->rot);
+        glVertexAttrib4fv(batch->loc.color, sprite->color);
+        glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+    }
+}
+
+void batch_end(gl_batch_t *batch) {
+    ASSERT(batch);
+    if(!batch->shader || !batch->count)
+        return;
+
+    gl_use_program(batch->shader);
+    glUniformMatrix4fv(batch->loc.pv, 1, GL_FALSE, (float *)batch->pvm);
+
+    if(batch->instanced) {
+        glBindBuffer(GL_ARRAY_BUFFER, batch->sprite_vbo);
+        glBufferData(GL_ARRAY_BUFFER, batch->capacity * sizeof(sprite_t), NULL, GL_STREAM_DRAW);
+        glBufferSubData(GL_ARRAY_BUFFER, 0, batch->count * sizeof(sprite_t), batch->sprites);
+        gl_bind_vao(batch->vao);
+    } else {
+        gl_bind_vao(0);
+        batch_setup_corner(batch);
+    }
+
+    unsigned first = 0;
+    for(unsigned i = 1; i <= batch->count; ++i) {
+        if(i < batch->count && batch->tex[i] == batch->tex[first])
+            continue;
+        XPLMBindTexture2d(batch->tex[first], 0);
+        batch_draw_run(batch, first, i - first);
+        first = i;
+    }
+
+    if(!batch->instanced)
+        glDisableVertexAttribArray(batch->loc.corner);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    batch->count = 0;
+    CHECK_GL();
+}
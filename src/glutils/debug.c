@@ -0,0 +1,177 @@
+/*===--------------------------------------------------------------------------------------------===
+ * debug.c
+ *
+ * Created by Amy Parent <amy@amyparent.com>
+ * Copyright (c) 2024 Laminar Research. All rights reserved
+ *
+ * Licensed under the MIT License
+ *===--------------------------------------------------------------------------------------------===
+*/
+#include <glutils/gl.h>
+#include <helpers/helpers.h>
+#include <helpers/thread.h>
+#include <stdio.h>
+
+// With KHR_debug, debug builds get the driver's errors and warnings through a callback, instead of
+// calling glGetError() after every draw, which makes the driver wait for the GPU. The callback is
+// only ours between gl_debug_begin() and gl_debug_end(), so the sim keeps its own the rest of the
+// time. Output is made synchronous meanwhile, but the callback still only queues messages, since
+// log_msg() can only be used on the sim's thread, and gl_debug_end() logs them. Past
+// GL_DEBUG_QUEUE messages between two flushes, or GL_DEBUG_MAX_LOGGED in all, they are only
+// counted.
+//
+// X-Plane's context isn't a debug context, so drivers don't have to report API errors through the
+// callback. gl_debug_end() reads the error flag too, so that they are neither lost nor left for
+// the sim to find, and logs what it held unless the callback already reported an error.
+
+#define GL_DEBUG_QUEUE      (16)
+#define GL_DEBUG_MAX_LOGGED (256)
+#define GL_DEBUG_MSG_LEN    (256)
+#define GL_DEBUG_MAX_ERRORS (8)
+
+typedef struct {
+    GLenum  type;
+    GLenum  severity;
+    GLuint  id;
+    char    text[GL_DEBUG_MSG_LEN];
+} gl_debug_msg_t;
+
+static struct {
+    bool            init;
+    bool            active;
+    mutex_t         lock;
+    gl_debug_msg_t  queue[GL_DEBUG_QUEUE];
+    unsigned        count;
+    unsigned        dropped;
+    unsigned        logged;
+    bool            reported;
+
+    GLDEBUGPROC     prev_proc;
+    void            *prev_param;
+    bool            prev_enabled;
+    bool            prev_sync;
+} debug = {0};
+
+bool gl_has_debug() {
+    return GLEW_VERSION_4_3 || GLEW_KHR_debug;
+}
+
+#ifdef GL_DEBUG
+static void GLAPIENTRY on_message(GLenum source, GLenum type, GLuint id, GLenum severity,
+                                  GLsizei length, const GLchar *text, const void *param) {
+    UNUSED(source);
+    UNUSED(length);
+    UNUSED(param);
+    if(severity == GL_DEBUG_SEVERITY_NOTIFICATION)
+        return;
+
+    mutex_enter(&debug.lock);
+    if(type == GL_DEBUG_TYPE_ERROR)
+        debug.reported = true;
+    if(debug.count < GL_DEBUG_QUEUE) {
+        gl_debug_msg_t *msg = &debug.queue[debug.count++];
+        msg->type = type;
+        msg->severity = severity;
+        msg->id = id;
+        snprintf(msg->text, sizeof(msg->text), "%s", text);
+    } else {
+        debug.dropped += 1;
+    }
+    mutex_exit(&debug.lock);
+}
+
+static const char *severity_str(GLenum severity) {
+    switch(severity) {
+    case GL_DEBUG_SEVERITY_HIGH: return "high";
+    case GL_DEBUG_SEVERITY_MEDIUM: return "medium";
+    default: return "low";
+    }
+}
+
+static void flush_messages() {
+    // Whatever the callback didn't report is logged the way CHECK_GL() would have.
+    GLenum errors[GL_DEBUG_MAX_ERRORS];
+    unsigned error_count = 0;
+    for(GLenum error; error_count < GL_DEBUG_MAX_ERRORS && (error = glGetError()) != GL_NO_ERROR;)
+        errors[error_count++] = error;
+
+    mutex_enter(&debug.lock);
+    if(debug.reported)
+        error_count = 0;
+    for(unsigned i = 0; i < error_count && debug.logged < GL_DEBUG_MAX_LOGGED; ++i) {
+        log_msg("OpenGL error code 0x%04x", errors[i]);
+        if(++debug.logged == GL_DEBUG_MAX_LOGGED)
+            log_msg("too many OpenGL messages, no longer logging them");
+    }
+    for(unsigned i = 0; i < debug.count && debug.logged < GL_DEBUG_MAX_LOGGED; ++i) {
+        const gl_debug_msg_t *msg = &debug.queue[i];
+        log_msg("OpenGL %s (%s, 0x%x): %s", msg->type == GL_DEBUG_TYPE_ERROR ? "error" : "message",
+                severity_str(msg->severity), msg->id, msg->text);
+        if(++debug.logged == GL_DEBUG_MAX_LOGGED)
+            log_msg("too many OpenGL messages, no longer logging them");
+    }
+    if(debug.dropped && debug.logged < GL_DEBUG_MAX_LOGGED)
+        log_msg("%u more OpenGL messages were not logged", debug.dropped);
+    debug.count = 0;
+    debug.dropped = 0;
+    debug.reported = false;
+    mutex_exit(&debug.lock);
+}
+#endif
+
+void gl_debug_begin() {
+#ifdef GL_DEBUG
+    if(debug.active || !gl_has_debug())
+        return;
+    if(!debug.init) {
+        mutex_init(&debug.lock);
+        debug.init = true;
+    }
+    glGetPointerv(GL_DEBUG_CALLBACK_FUNCTION, (void **)&debug.prev_proc);
+    glGetPointerv(GL_DEBUG_CALLBACK_USER_PARAM, &debug.prev_param);
+    debug.prev_enabled = glIsEnabled(GL_DEBUG_OUTPUT);
+    debug.prev_sync = glIsEnabled(GL_DEBUG_OUTPUT_SYNCHRONOUS);
+    glDebugMessageCallback(on_message, NULL);
+    glEnable(GL_DEBUG_OUTPUT);
+    glEnable(GL_DEBUG_OUTPUT_SYNCHRONOUS);
+    debug.active = true;
+#endif
+}
+
+void gl_debug_end() {
+#ifdef GL_DEBUG
+    if(!debug.active)
+        return;
+    glDebugMessageCallback(debug.prev_proc, debug.prev_param);
+    if(!debug.prev_enabled)
+        glDisable(GL_DEBUG_OUTPUT);
+    if(!debug.prev_sync)
+        glDisable(GL_DEBUG_OUTPUT_SYNCHRONOUS);
+    debug.active = false;
+    flush_messages();
+#endif
+}
+
+void gl_label(GLenum type, GLuint id, const char *name) {
+    if(id && gl_has_debug())
+        glObjectLabel(type, id, -1, name);
+}
+
+void gl_push_group(const char *name) {
+    if(gl_has_debug())
+        glPushDebugGroup(GL_DEBUG_SOURCE_APPLICATION, 0, -1, name);
+}
+
+void gl_pop_group() {
+    if(gl_has_debug())
+        glPopDebugGroup();
+}
+
+void check_gl(const char *where, int line) {
+    // While our callback is installed, gl_debug_end() picks errors up instead.
+    if(debug.active)
+        return;
+    GLenum error = glGetError();
+    if(error == GL_NO_ERROR) return;
+    log_msg("%s() OpenGL error code 0x%04x line %d", where, error, line);
+}
@@ -8,15 +8,17 @@
  *===--------------------------------------------------------------------------------------------===
 */
 #include <glutils/gl.h>
-// #define STB_IMAGE_IMPLEMENTATION
-// We don't define IMPLEMENTATION because otherwise we get link-time errors, since NanoVG already
-// does that.
+#define STB_IMAGE_IMPLEMENTATION
 #include <glutils/stb_image.h>
-#include <helpers/helpers.h>
+#include "glutils_impl.h"
 #include <stdlib.h>
 
 
 GLuint gl_fbo_new(unsigned width, unsigned height, GLuint *out_tex) {
+    return gl_fbo_new_fmt(width, height, GL_SRGB8_ALPHA8, out_tex);
+}
+
+GLuint gl_fbo_new_fmt(unsigned width, unsigned height, GLenum format, GLuint *out_tex) {
     ASSERT(width > 0);
     ASSERT(height > 0);
     ASSERT(out_tex != NULL);
@@ -28,7 +30,7 @@ GLuint gl_fbo_new(unsigned width, unsigned height, GLuint *out_tex) {
     
     glGenTextures(1, &tex);
     glBindTexture(GL_TEXTURE_2D, tex);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_SRGB8_ALPHA8, width, height, 0, GL_BGRA, GL_UNSIGNED_BYTE, NULL);
+    glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, GL_BGRA, GL_UNSIGNED_BYTE, NULL);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
@@ -104,47 +106,181 @@ GLuint gl_program_new(const char *vertex, const char *fragment) {
     return prog;
 }
 
-static char *load_file(const char *path) {
-    FILE *f = fopen(path, "rb");
-    if(f == NULL) {
-        log_msg("shader load error: cannot open '%s'", path);
-        return NULL;
-    }
+GLuint gl_compute_program_new(const char *source) {
+    ASSERT(source);
     
-    fseek(f, 0, SEEK_END);
-    size_t size = ftell(f);
-    fseek(f, 0, SEEK_SET);
+    GLuint comp = gl_load_shader(source, GL_COMPUTE_SHADER);
+    if(!comp)
+        return 0;
     
-    char *src = safe_calloc(1, size+1);
-    fread(src, 1, size, f);
-    src[size] = '\0';
-    fclose(f);
+    GLuint prog = glCreateProgram();
+    glAttachShader(prog, comp);
+    glLinkProgram(prog);
+    glDeleteShader(comp);
     
+    if(!check_program(prog)) {
+        glDeleteProgram(prog);
+        return 0;
+    }
+    return prog;
+}
+
+bool gl_program_relink(GLuint prog) {
+    ASSERT(prog);
+    glLinkProgram(prog);
+    return check_program(prog);
+}
+
+static char *load_file(const char *path) {
+    char *src = fs_read(path, NULL);
+    if(src == NULL)
+        log_msg("shader load error: cannot read '%s'", path);
     return src;
 }
 
-GLuint gl_program_new_file(const char *vert_path, const char *frag_path) {
+// Programs built from files are cached under the name of their first file.
+static const char *cache_name(const char *path) {
+    const char *name = strrchr(path, DIR_SEP);
+    return name ? name + 1 : path;
+}
+
+static bool has_parallel_compile() {
+    return GLEW_KHR_parallel_shader_compile || GLEW_ARB_parallel_shader_compile;
+}
+
+// Compiles and links without checking the results, so we don't wait for the driver.
+static GLuint submit_program(const char **sources, const GLenum *types, unsigned count) {
+    GLuint prog = glCreateProgram();
+    for(unsigned i = 0; i < count; ++i) {
+        GLint size = strlen(sources[i]);
+        GLuint sh = glCreateShader(types[i]);
+        glShaderSource(sh, 1, &sources[i], &size);
+        glCompileShader(sh);
+        glAttachShader(prog, sh);
+        // Shaders are only deleted once detached, so gl_program_end() can still get their logs.
+        glDeleteShader(sh);
+    }
+    progcache_prepare(prog);
+    glLinkProgram(prog);
+    return prog;
+}
+
+static void link_begin(gl_link_t *link, const char *name, const char **sources,
+                       const GLenum *types, unsigned count) {
+    memset(link, 0, sizeof(*link));
+    snprintf(link->name, sizeof(link->name), "%s", name);
+    link->key = progcache_key(sources, count);
+    link->id = progcache_load(link->name, link->key);
+    link->cached = link->id != 0;
+    if(!link->cached)
+        link->id = submit_program(sources, types, count);
+}
+
+void gl_program_begin(gl_link_t *link, const char *name, const char *vertex, const char *fragment) {
+    ASSERT(link);
+    ASSERT(name);
+    ASSERT(vertex);
+    ASSERT(fragment);
+    
+    const char *sources[] = {vertex, fragment};
+    const GLenum types[] = {GL_VERTEX_SHADER, GL_FRAGMENT_SHADER};
+    link_begin(link, name, sources, types, 2);
+}
+
+void gl_compute_program_begin(gl_link_t *link, const char *name, const char *source) {
+    ASSERT(link);
+    ASSERT(name);
+    ASSERT(source);
+    
+    const char *sources[] = {source};
+    const GLenum types[] = {GL_COMPUTE_SHADER};
+    link_begin(link, name, sources, types, 1);
+}
+
+void gl_program_begin_file(gl_link_t *link, const char *vert_path, const char *frag_path) {
+    ASSERT(link);
     ASSERT(vert_path);
     ASSERT(frag_path);
     
-    GLuint prog = 0;
+    memset(link, 0, sizeof(*link));
     char *vert = load_file(vert_path);
     char *frag = load_file(frag_path);
     
-    if(vert != NULL && frag != NULL) {
-        prog = gl_program_new(vert, frag);
-    }
+    if(vert != NULL && frag != NULL)
+        gl_program_begin(link, cache_name(vert_path), vert, frag);
     
     if(vert != NULL)
         free(vert);
     if(frag != NULL)
         free(frag);
+}
+
+void gl_compute_program_begin_file(gl_link_t *link, const char *path) {
+    ASSERT(link);
+    ASSERT(path);
+    
+    memset(link, 0, sizeof(*link));
+    char *comp = load_file(path);
+    if(comp != NULL) {
+        gl_compute_program_begin(link, cache_name(path), comp);
+        free(comp);
+    }
+}
+
+bool gl_program_ready(const gl_link_t *link) {
+    ASSERT(link);
+    if(!link->id || link->cached || !has_parallel_compile())
+        return true;
+    
+    GLint is_done = GL_TRUE;
+    glGetProgramiv(link->id, GL_COMPLETION_STATUS_KHR, &is_done);
+    return is_done == GL_TRUE;
+}
+
+GLuint gl_program_end(gl_link_t *link) {
+    ASSERT(link);
+    GLuint prog = link->id;
+    link->id = 0;
+    if(!prog)
+        return 0;
+    if(link->cached) {
+        gl_label(GL_PROGRAM, prog, link->name);
+        return prog;
+    }
+    
+    GLint is_linked = GL_FALSE;
+    glGetProgramiv(prog, GL_LINK_STATUS, &is_linked);
+    if(is_linked != GL_TRUE) {
+        GLuint shaders[2];
+        GLsizei count = 0;
+        glGetAttachedShaders(prog, 2, &count, shaders);
+        for(GLsizei i = 0; i < count; ++i)
+            check_shader(shaders[i]);
+        check_program(prog);
+        glDeleteProgram(prog);
+        return 0;
+    }
+    
+    progcache_store(link->name, link->key, prog);
+    gl_label(GL_PROGRAM, prog, link->name);
     return prog;
 }
 
+GLuint gl_program_new_file(const char *vert_path, const char *frag_path) {
+    gl_link_t link;
+    gl_program_begin_file(&link, vert_path, frag_path);
+    return gl_program_end(&link);
+}
+
+GLuint gl_compute_program_new_file(const char *path) {
+    gl_link_t link;
+    gl_compute_program_begin_file(&link, path);
+    return gl_program_end(&link);
+}
+
 GLuint gl_load_shader(const char *source, int type) {
     ASSERT(source);
-    ASSERT(type == GL_VERTEX_SHADER || type == GL_FRAGMENT_SHADER);
+    ASSERT(type == GL_VERTEX_SHADER || type == GL_FRAGMENT_SHADER || type == GL_COMPUTE_SHADER);
     GLint size = strlen(source);
     GLuint sh = glCreateShader(type);
     glShaderSource(sh, 1, &source, &size);
@@ -156,6 +292,22 @@ GLuint gl_load_shader(const char *source, int type) {
     return sh;
 }
 
+// With immutable storage, textures are allocated once and never re-specified.
+static bool has_tex_storage() {
+    return GLEW_VERSION_4_2 || GLEW_ARB_texture_storage;
+}
+
+static void tex_alloc(GLenum format, unsigned levels, unsigned width, unsigned height) {
+    if(has_tex_storage()) {
+        glTexStorage2D(GL_TEXTURE_2D, levels, format, width, height);
+        return;
+    }
+    for(unsigned i = 0; i < levels; ++i) {
+        glTexImage2D(GL_TEXTURE_2D, i, format, texfile_level_dim(width, i),
+                     texfile_level_dim(height, i), 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+    }
+}
+
 GLuint gl_tex_new(unsigned width, unsigned height) {
     ASSERT(width > 0);
     ASSERT(height > 0);
@@ -163,7 +315,7 @@ GLuint gl_tex_new(unsigned width, unsigned height) {
     GLuint tex = 0;
     glGenTextures(1, &tex);
     glBindTexture(GL_TEXTURE_2D, tex);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+    tex_alloc(GL_RGBA8, 1, width, height);
 
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
@@ -173,7 +325,100 @@ GLuint gl_tex_new(unsigned width, unsigned height) {
     return tex;
 }
 
+static GLenum texfile_gl_format(texfile_format_t format) {
+    switch(format) {
+    case TEXFILE_RGBA8: return GL_RGBA8;
+    case TEXFILE_BC1: return GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+    case TEXFILE_BC3: return GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+    }
+    return GL_RGBA8;
+}
+
+// Block-compressed levels are uploaded as they are when the driver has S3TC, and decoded to RGBA
+// on the CPU when it doesn't.
+static void tex_upload_level(const texfile_t *file, unsigned level) {
+    unsigned w = texfile_level_dim(file->width, level);
+    unsigned h = texfile_level_dim(file->height, level);
+    
+    if(!texfile_is_compressed(file->format)) {
+        glTexSubImage2D(GL_TEXTURE_2D, level, 0, 0, w, h, GL_RGBA, GL_UNSIGNED_BYTE,
+                        file->level_data[level]);
+    } else if(GLEW_EXT_texture_compression_s3tc) {
+        GLenum format = texfile_gl_format(file->format);
+        if(has_tex_storage()) {
+            glCompressedTexSubImage2D(GL_TEXTURE_2D, level, 0, 0, w, h, format,
+                                      file->level_size[level], file->level_data[level]);
+        } else {
+            glCompressedTexImage2D(GL_TEXTURE_2D, level, format, w, h, 0,
+                                   file->level_size[level], file->level_data[level]);
+        }
+    } else {
+        uint8_t *pixels = texfile_decode(file, level);
+        glTexSubImage2D(GL_TEXTURE_2D, level, 0, 0, w, h, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+        free(pixels);
+    }
+}
+
+GLuint gl_tex_new_texfile(const texfile_t *file) {
+    ASSERT(file);
+    
+    GLuint tex = 0;
+    glGenTextures(1, &tex);
+    glBindTexture(GL_TEXTURE_2D, tex);
+    
+    bool native = !texfile_is_compressed(file->format) || GLEW_EXT_texture_compression_s3tc;
+    GLenum format = native ? texfile_gl_format(file->format) : GL_RGBA8;
+    // Without immutable storage, compressed levels are allocated as they're uploaded.
+    if(has_tex_storage() || format == GL_RGBA8)
+        tex_alloc(format, file->levels, file->width, file->height);
+    for(unsigned i = 0; i < file->levels; ++i)
+        tex_upload_level(file, i);
+    
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, file->levels - 1);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER,
+                    file->levels > 1 ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    CHECK_GL();
+    return tex;
+}
+
+// Converted textures sit next to the image they were made from, with an .rtex extension. They are
+// uploaded straight from the mapped file.
+static GLuint load_texfile(const char *path, int *w, int *h) {
+    const char *ext = strrchr(path, '.');
+    size_t len = ext && !strchr(ext, DIR_SEP) ? (size_t)(ext - path) : strlen(path);
+    char *tex_path = safe_calloc(len + 6, 1);
+    memcpy(tex_path, path, len);
+    strcat(tex_path, ".rtex");
+    
+    size_t size = 0;
+    const uint8_t *data = fs_map(tex_path, &size);
+    if(!data) {
+        free(tex_path);
+        return 0;
+    }
+    
+    GLuint tex = 0;
+    texfile_t file;
+    if(texfile_parse(data, size, &file)) {
+        tex = gl_tex_new_texfile(&file);
+        *w = file.width;
+        *h = file.height;
+    } else {
+        log_msg("`%s` is not a valid texture file", tex_path);
+    }
+    fs_unmap(data, size);
+    free(tex_path);
+    return tex;
+}
+
 GLuint gl_load_tex(const char *path, int *w, int *h) {
+    GLuint tex = load_texfile(path, w, h);
+    if(tex)
+        return tex;
+    
     // stbi_set_flip_vertically_on_load(true);
     int components = 0;
     uint8_t *data = stbi_load(path, w, h, &components, 4);
@@ -187,15 +432,8 @@ GLuint gl_load_tex(const char *path, int *w, int *h) {
         return 0;
     }
 
-    GLuint tex = gl_tex_new(*w, *h);
-    glBindTexture(GL_TEXTURE_2D, tex);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, *w, *h, 0, GL_RGBA, GL_UNSIGNED_BYTE, data);
+    tex = gl_tex_new(*w, *h);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, *w, *h, GL_RGBA, GL_UNSIGNED_BYTE, data);
     free(data);
     return tex;
 }
-
-void check_gl(const char *where, int line) {
-    GLenum error = glGetError();
-    if(error == GL_NO_ERROR) return;
-    log_msg("%s() OpenGL error code 0x%04x line %d", where, error, line);
-}
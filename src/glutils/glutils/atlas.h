@@ -0,0 +1,50 @@
+/*===--------------------------------------------------------------------------------------------===
+ * atlas.h
+ *
+ * Created by Amy Parent <amy@amyparent.com>
+ * Copyright (c) 2024 Laminar Research. All rights reserved
+ *
+ * Licensed under the MIT License
+ *===--------------------------------------------------------------------------------------------===
+*/
+#ifndef _ATLAS_H_
+#define _ATLAS_H_
+
+#include <glutils/gl.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Packs images into a single texture at load time. Images are added by path (adding the same path
+// twice returns the same image), then the whole atlas is uploaded at once by atlas_build(). Each
+// image is surrounded by `padding` pixels copied from its edges, so filtering doesn't bleed from
+// its neighbours.
+typedef struct gl_atlas_t gl_atlas_t;
+
+gl_atlas_t *atlas_new(unsigned width, unsigned padding);
+void atlas_destroy(gl_atlas_t *atlas);
+
+// Decodes the image at `path` and returns its index in the atlas, or -1 if it can't be loaded.
+int atlas_add_file(gl_atlas_t *atlas, const char *path);
+
+// Adds an already decoded RGBA image under `key`, taking ownership of `data` (which can be NULL if
+// the image couldn't be loaded). Keys work like paths in atlas_add_file().
+int atlas_add_image(gl_atlas_t *atlas, const char *key, uint8_t *data, unsigned w, unsigned h);
+
+// Packs and uploads the images added so far. Returns the atlas texture, or 0 on failure.
+GLuint atlas_build(gl_atlas_t *atlas);
+
+// Uploads an atlas that was packed ahead of time (see texconv) from a texture container in memory,
+// instead of adding and packing images. Its images are named after the files they were packed
+// from. Returns the atlas texture, or 0 on failure.
+GLuint atlas_load(gl_atlas_t *atlas, const uint8_t *data, size_t size);
+
+// Returns the index of the image added or loaded as `key`, or -1 if there is none.
+int atlas_find_image(const gl_atlas_t *atlas, const char *key);
+
+GLuint atlas_tex(const gl_atlas_t *atlas);
+
+// Gets the rect {x, y, w, h}, in texture coordinates, of image `idx`. Images that failed to load
+// get an empty rect.
+void atlas_get_uv(const gl_atlas_t *atlas, int idx, vec4 uv);
+
+#endif /* ifndef _ATLAS_H_ */
@@ -0,0 +1,36 @@
+/*===--------------------------------------------------------------------------------------------===
+ * batch.h
+ *
+ * Created by Amy Parent <amy@amyparent.com>
+ * Copyright (c) 2024 Laminar Research. All rights reserved
+ *
+ * Licensed under the MIT License
+ *===--------------------------------------------------------------------------------------------===
+*/
+#ifndef _BATCH_H_
+#define _BATCH_H_
+
+#include <glutils/gl.h>
+
+// A sprite batch queues textured, rotated rectangles and draws them with one instanced draw call
+// per run of sprites that share a texture. Sprites are positioned and rotated on the GPU, so
+// queueing one is just a copy.
+typedef struct gl_batch_t gl_batch_t;
+
+gl_batch_t *batch_new(unsigned capacity);
+void batch_destroy(gl_batch_t *batch);
+
+void batch_begin(gl_batch_t *batch, mat4 pvm);
+
+// Sets the colour the sprites queued from now on are multiplied by. batch_begin() resets it to
+// white.
+void batch_set_color(gl_batch_t *batch, const vec4 color);
+
+// Queues a sprite of `size` at `pos`, rotated by `rot` degrees around its centre like quad_render()
+// does. `uv` is the part of `tex` to show, as {x, y, w, h} in texture coordinates.
+void batch_add(gl_batch_t *batch, unsigned tex, vec2 pos, vec2 size, float rot, const vec4 uv);
+
+// Draws everything queued since batch_begin().
+void batch_end(gl_batch_t *batch);
+
+#endif /* ifndef _BATCH_H_ */
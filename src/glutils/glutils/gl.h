@@ -12,8 +12,10 @@
 
 #include <math.h>
 #include <stdbool.h>
+#include <stdint.h>
 #include <cglm/cglm.h>
 #include <glew.h>
+#include <glutils/texfile.h>
 
 #ifndef NDEBUG
 #define GL_DEBUG
@@ -45,15 +47,65 @@ typedef struct vect2_t {
 #define IS_NULL_VEC2(v)     (isnan((v)[0]) || isnan((v)[1]))
 
 GLuint gl_fbo_new(unsigned width, unsigned height, GLuint *tex);
+GLuint gl_fbo_new_fmt(unsigned width, unsigned height, GLenum format, GLuint *tex);
 
 GLuint gl_program_new_file(const char *vertex, const char *fragment);
 GLuint gl_program_new(const char *vertex, const char *fragment);
+GLuint gl_compute_program_new_file(const char *path);
+GLuint gl_compute_program_new(const char *source);
 GLuint gl_load_shader(const char *source, int type);
+// Links a program again (after its attribute locations change, say). Logs why if it fails.
+bool gl_program_relink(GLuint prog);
+
+// Programs can also be linked without waiting for the driver. gl_program_begin*() submit a
+// program, and gl_program_end() checks it and returns it (or 0 if it failed to build). `name`
+// identifies the program in the program cache (file-based programs use their first file's). With GL_KHR_parallel_shader_compile, the driver builds programs in
+// the background until gl_program_ready() says it's done. Without it, programs are always ready,
+// and gl_program_end() waits for the driver like gl_program_new_file() does.
+typedef struct {
+    GLuint      id;
+    bool        cached;
+    uint64_t    key;
+    char        name[64];
+} gl_link_t;
+
+void gl_program_begin(gl_link_t *link, const char *name, const char *vertex, const char *fragment);
+void gl_compute_program_begin(gl_link_t *link, const char *name, const char *source);
+void gl_program_begin_file(gl_link_t *link, const char *vertex, const char *fragment);
+void gl_compute_program_begin_file(gl_link_t *link, const char *path);
+bool gl_program_ready(const gl_link_t *link);
+GLuint gl_program_end(gl_link_t *link);
+// Loads the image at `path`, or the converted texture next to it if there is one (see texfile.h).
 GLuint gl_load_tex(const char *path, int *w, int *h);
+// RGBA textures, with immutable storage when the driver has it: upload with glTexSubImage2D().
 GLuint gl_tex_new(unsigned width, unsigned height);
+// Uploads a texture file with its mipmaps. Block-compressed files are decoded on the CPU if the
+// driver doesn't have S3TC.
+GLuint gl_tex_new_texfile(const texfile_t *file);
 
 void check_gl(const char *where, int line);
 
+// KHR_debug, when the driver has it (see debug.c). In debug builds, gl_debug_begin() routes the
+// driver's messages to log_msg() until gl_debug_end(), which then reads glGetError() once, instead
+// of CHECK_GL() after every call. gl_state_invalidate() and gl_state_reset() call them. Labels and
+// groups show up in GL debuggers.
+bool gl_has_debug(void);
+void gl_debug_begin(void);
+void gl_debug_end(void);
+void gl_label(GLenum type, GLuint id, const char *name);
+void gl_push_group(const char *name);
+void gl_pop_group(void);
+
+// A minimal cache of the bindings glutils changes, so redundant binds can be skipped. The sim
+// changes GL state behind our back: call gl_state_invalidate() whenever we get control back (the
+// start of draw callbacks), and gl_state_reset() before handing it over.
+bool gl_has_vao(void);
+void gl_state_invalidate(void);
+void gl_state_reset(void);
+void gl_use_program(GLuint program);
+void gl_delete_program(GLuint program);
+void gl_bind_vao(GLuint vao);
+
 #ifdef GL_DEBUG
 #define CHECK_GL() check_gl(__FUNCTION__, __LINE__)
 #else
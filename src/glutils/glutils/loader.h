@@ -0,0 +1,48 @@
+/*===--------------------------------------------------------------------------------------------===
+ * loader.h
+ *
+ * Created by Amy Parent <amy@amyparent.com>
+ * Copyright (c) 2024 Laminar Research. All rights reserved
+ *
+ * Licensed under the MIT License
+ *===--------------------------------------------------------------------------------------------===
+*/
+#ifndef _LOADER_H_
+#define _LOADER_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Decodes images and reads files on worker threads, so that loading resources doesn't stall the
+// sim. Jobs are queued, then run by loader_start(). Their results are collected from the sim
+// thread, once loader_done() says every job is finished, and uploaded to OpenGL from there.
+typedef struct gl_loader_t gl_loader_t;
+
+typedef enum {
+    LOAD_IMAGE,
+    LOAD_FILE,
+} gl_load_type_t;
+
+gl_loader_t *loader_new(void);
+// Jobs that haven't started yet are dropped, but the ones in progress are waited for.
+void loader_destroy(gl_loader_t *loader);
+
+// Queues the resource at `path` and returns its job. Queuing the same path twice returns the same
+// job.
+int loader_add(gl_loader_t *loader, gl_load_type_t type, const char *path);
+// Same as loader_add(), for a resource that is already in memory (and stays there until the loader
+// is done). `key` stands in for its path.
+int loader_add_mem(gl_loader_t *loader, gl_load_type_t type, const char *key, const uint8_t *src,
+                   size_t size);
+void loader_start(gl_loader_t *loader, unsigned threads);
+bool loader_done(gl_loader_t *loader);
+
+const char *loader_path(const gl_loader_t *loader, int job);
+
+// Hand over the RGBA pixels or contents a finished job loaded, which the caller must free. They
+// return NULL if the job failed, or if its result was already taken.
+uint8_t *loader_take_image(gl_loader_t *loader, int job, unsigned *w, unsigned *h);
+uint8_t *loader_take_file(gl_loader_t *loader, int job, size_t *size);
+
+#endif /* ifndef _LOADER_H_ */
@@ -0,0 +1,34 @@
+/*===--------------------------------------------------------------------------------------------===
+ * pack.h
+ *
+ * Created by Amy Parent <amy@amyparent.com>
+ * Copyright (c) 2024 Laminar Research. All rights reserved
+ *
+ * Licensed under the MIT License
+ *===--------------------------------------------------------------------------------------------===
+*/
+#ifndef _PACK_H_
+#define _PACK_H_
+
+#include <stdint.h>
+
+// The CPU side of texture atlases: placing RGBA images in a single image. It doesn't use OpenGL,
+// so the build-time texture converter shares it with atlas.c.
+typedef struct {
+    uint8_t     *data;
+    unsigned    w, h;
+    unsigned    x, y;
+} pack_img_t;
+
+// Places the images that have data, tallest first, each where it sits lowest (then leftmost).
+// `width` grows to fit the widest image. Each image is surrounded by `padding` pixels, and placed
+// on a multiple of `align` pixels (block-compressed textures want images to start on a block).
+// Returns the height of the packed images.
+unsigned pack_images(pack_img_t *images, unsigned count, unsigned *width, unsigned padding,
+                     unsigned align);
+
+// Copies a packed image into `pixels`, `width` pixels wide, extruding its edges into the padding
+// around it, so filtering doesn't bleed from its neighbours.
+void pack_blit(uint8_t *pixels, unsigned width, const pack_img_t *img, unsigned padding);
+
+#endif /* ifndef _PACK_H_ */
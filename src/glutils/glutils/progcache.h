@@ -0,0 +1,26 @@
+/*===--------------------------------------------------------------------------------------------===
+ * progcache.h
+ *
+ * Created by Amy Parent <amy@amyparent.com>
+ * Copyright (c) 2024 Laminar Research. All rights reserved
+ *
+ * Licensed under the MIT License
+ *===--------------------------------------------------------------------------------------------===
+*/
+#ifndef _PROGCACHE_H_
+#define _PROGCACHE_H_
+
+#include <glutils/gl.h>
+
+// Keeps linked programs on disk, so that the next run can skip compiling them. Once the cache is
+// set up, gl_program_new_file() and gl_compute_program_new_file() go through it. Binaries are
+// keyed on the shader sources and on the GL vendor, renderer and version, and are rebuilt from
+// source whenever any of those change, or the driver refuses them.
+void gl_progcache_init(const char *dir);
+void gl_progcache_fini(void);
+
+// Ignores the binaries already on disk from now on: programs are built from source again, and the
+// cache is refreshed with them.
+void gl_progcache_invalidate(void);
+
+#endif /* ifndef _PROGCACHE_H_ */
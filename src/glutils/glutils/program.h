@@ -0,0 +1,70 @@
+/*===--------------------------------------------------------------------------------------------===
+ * program.h
+ *
+ * Created by Amy Parent <amy@amyparent.com>
+ * Copyright (c) 2024 Laminar Research. All rights reserved
+ *
+ * Licensed under the MIT License
+ *===--------------------------------------------------------------------------------------------===
+*/
+#ifndef _PROGRAM_H_
+#define _PROGRAM_H_
+
+#include <glutils/gl.h>
+#include <stddef.h>
+
+#define GL_PROGRAM_MAX_UNIFORMS 8
+#define GL_BLOCK_MAX_MEMBERS    16
+
+// A uniform block is a set of parameters shared by several programs, mirrored by a C struct laid
+// out with std140 rules. With uniform buffers, it is uploaded once per update and every program
+// reads from the same buffer. Without them, the shaders declare the block as a struct uniform, and
+// each program copies the members it uses the first time it is used after an update.
+typedef enum {
+    GL_BLOCK_FLOAT,
+    GL_BLOCK_VEC2,
+} gl_block_type_t;
+
+typedef struct {
+    const char          *name;
+    gl_block_type_t     type;
+    size_t              offset;
+} gl_block_member_t;
+
+typedef struct {
+    const char              *name;      // Name of the block instance in the shaders
+    unsigned                binding;
+    size_t                  size;
+    unsigned                count;
+    gl_block_member_t       members[GL_BLOCK_MAX_MEMBERS];
+} gl_block_desc_t;
+
+typedef struct gl_block_t gl_block_t;
+
+gl_block_t *gl_block_new(const gl_block_desc_t *desc, bool use_ubo);
+void gl_block_destroy(gl_block_t *block);
+
+// Copies `data` into the block if it changed, and binds the buffer to the block's binding point.
+void gl_block_update(gl_block_t *block, const void *data);
+
+// A linked program and the locations of its uniforms, resolved once when it is created. Programs
+// must be re-initialised when they are re-linked (for example when shaders are reloaded).
+typedef struct {
+    GLuint              id;
+    GLint               loc[GL_PROGRAM_MAX_UNIFORMS];
+
+    const gl_block_t    *block;
+    GLint               block_loc[GL_BLOCK_MAX_MEMBERS];
+    unsigned            block_gen;
+} gl_program_t;
+
+// Takes ownership of `id`. `names` are the uniforms outside of `block` the caller wants to set, and
+// end up in `loc` in the same order (-1 for the ones the program doesn't use). `block` can be NULL.
+void gl_program_init(gl_program_t *prog, GLuint id, const gl_block_t *block,
+                     const char **names, unsigned count);
+void gl_program_fini(gl_program_t *prog);
+
+// Binds the program, and brings its copy of the block up to date if we don't have uniform buffers.
+void gl_program_use(gl_program_t *prog);
+
+#endif /* ifndef _PROGRAM_H_ */
@@ -16,9 +16,26 @@ typedef struct gl_quad_t gl_quad_t;
 
 gl_quad_t *quad_new(unsigned texture, unsigned shader);
 void quad_set_tex(gl_quad_t *quad, unsigned tex);
+// Sets the part of the texture drawn on the quad, as {x, y, w, h} in texture coordinates.
+void quad_set_uv(gl_quad_t *quad, const vec4 uv);
 void quad_set_shader(gl_quad_t *wuad, unsigned shader);
 void quad_destroy(gl_quad_t *quad);
 
 void quad_render(mat4 pvm, gl_quad_t *quad, vec2 pos, vec2 size, float rot, float alpha);
 
+// A sector is a slice of a disc, drawn as a triangle fan. It lets passes that only update part of
+// a radial display (like an antenna sweep) rasterise that part, instead of a full quad.
+typedef struct gl_sector_t gl_sector_t;
+
+gl_sector_t *sector_new(unsigned texture, unsigned shader);
+void sector_set_tex(gl_sector_t *sector, unsigned tex);
+void sector_set_shader(gl_sector_t *sector, unsigned shader);
+void sector_destroy(gl_sector_t *sector);
+
+// Draws the slice of the disc centred on `center` between angles `start` and `end`, in radians
+// clockwise from +Y. Texture coordinates are those of a quad spanning (0, 0) to `size`, so the
+// sector shows the matching slice of the texture.
+void sector_render(mat4 pvm, gl_sector_t *sector, vec2 size, vec2 center, float radius,
+                   float start, float end, float alpha);
+
 #endif /*_RENDERER_H_ */
@@ -0,0 +1,103 @@
+/*===--------------------------------------------------------------------------------------------===
+ * texfile.h
+ *
+ * Created by Amy Parent <amy@amyparent.com>
+ * Copyright (c) 2024 Laminar Research. All rights reserved
+ *
+ * Licensed under the MIT License
+ *===--------------------------------------------------------------------------------------------===
+*/
+#ifndef _TEXFILE_H_
+#define _TEXFILE_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Textures converted at build time (by texconv), so they can be uploaded as they are instead of
+// being decoded at load time. A file is a header, a table of named rects (the images packed in it,
+// if it's an atlas), a table of glyph metrics (if it's a font, one per rect), then each mip level
+// as a size followed by its payload. Every part is a multiple of 16 bytes, so payloads stay
+// aligned when the file is.
+#define TEXFILE_MAGIC       (0x58455452u) // "RTEX"
+#define TEXFILE_VERSION     (2)
+#define TEXFILE_MAX_LEVELS  (16)
+#define TEXFILE_NAME_MAX    (32)
+#define TEXFILE_ALIGN       (16)
+
+// BC1 and BC3 are the S3TC formats (DXT1 and DXT5): 4x4 pixel blocks of 8 and 16 bytes. BC1
+// textures are opaque.
+typedef enum {
+    TEXFILE_RGBA8,
+    TEXFILE_BC1,
+    TEXFILE_BC3,
+} texfile_format_t;
+
+typedef struct {
+    uint32_t    magic;
+    uint32_t    version;
+    uint32_t    format;
+    uint32_t    width;
+    uint32_t    height;
+    uint32_t    levels;
+    uint32_t    rect_count;
+    uint32_t    glyph_count;
+    float       font_size;
+    uint32_t    reserved[3];
+} texfile_header_t;
+
+typedef struct {
+    char        name[TEXFILE_NAME_MAX];
+    uint32_t    x, y;
+    uint32_t    w, h;
+} texfile_rect_t;
+
+// A glyph's image is the rect with the same index. Its offset is from the pen, on the baseline, to
+// the image's top-left corner (Y grows downwards), and all metrics are in pixels at font_size.
+typedef struct {
+    uint32_t    codepoint;
+    float       advance;
+    float       x_off, y_off;
+} texfile_glyph_t;
+
+typedef struct {
+    uint32_t    size;
+    uint32_t    reserved[3];
+} texfile_level_t;
+
+// A parsed texture file. It points into the data it was parsed from.
+typedef struct {
+    texfile_format_t    format;
+    unsigned            width;
+    unsigned            height;
+    unsigned            levels;
+    const uint8_t       *level_data[TEXFILE_MAX_LEVELS];
+    size_t              level_size[TEXFILE_MAX_LEVELS];
+    unsigned            rect_count;
+    const uint8_t       *rects;
+    unsigned            glyph_count;
+    const uint8_t       *glyphs;
+    float               font_size;
+} texfile_t;
+
+// Checks that `data` holds a valid texture file, and fills `file` if it does.
+bool texfile_parse(const uint8_t *data, size_t size, texfile_t *file);
+void texfile_get_rect(const texfile_t *file, unsigned idx, texfile_rect_t *rect);
+void texfile_get_glyph(const texfile_t *file, unsigned idx, texfile_glyph_t *glyph);
+
+static inline unsigned texfile_level_dim(unsigned size, unsigned level) {
+    return size >> level ? size >> level : 1;
+}
+
+bool texfile_is_compressed(texfile_format_t format);
+size_t texfile_level_size(texfile_format_t format, unsigned width, unsigned height);
+
+// Decodes mip `level` of a block-compressed texture to RGBA, for drivers that can't sample it.
+// The caller owns the returned pixels.
+uint8_t *texfile_decode(const texfile_t *file, unsigned level);
+
+static inline size_t texfile_align(size_t size) {
+    return (size + TEXFILE_ALIGN - 1) & ~(size_t)(TEXFILE_ALIGN - 1);
+}
+
+#endif /* ifndef _TEXFILE_H_ */
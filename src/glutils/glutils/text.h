@@ -0,0 +1,33 @@
+/*===--------------------------------------------------------------------------------------------===
+ * text.h
+ *
+ * Created by Amy Parent <amy@amyparent.com>
+ * Copyright (c) 2024 Laminar Research. All rights reserved
+ *
+ * Licensed under the MIT License
+ *===--------------------------------------------------------------------------------------------===
+*/
+#ifndef _TEXT_H_
+#define _TEXT_H_
+
+#include <glutils/batch.h>
+#include <glutils/gl.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Draws text from a font baked by texconv (see texfile.h), so no font is rasterised at runtime.
+// Glyphs are queued as sprites in a batch, so a whole string (or screen of text) is one draw. The
+// baked glyphs are white with premultiplied alpha: tint them with batch_set_color(), and blend
+// with (GL_ONE, GL_ONE_MINUS_SRC_ALPHA).
+typedef struct gl_font_t gl_font_t;
+
+// Uploads a baked font from memory. Returns NULL if `data` isn't one.
+gl_font_t *font_load(const uint8_t *data, size_t size);
+void font_destroy(gl_font_t *font);
+
+// Queues the UTF-8 string `str`, `size` pixels high, starting on the baseline at `pos`. Y grows
+// downwards, like in most 2D text APIs. Characters that weren't baked are skipped. Returns the
+// pen position after the last character.
+float font_draw(const gl_font_t *font, gl_batch_t *batch, vec2 pos, float size, const char *str);
+
+#endif /* ifndef _TEXT_H_ */
@@ -20,30 +20,55 @@
 #include <glutils/renderer.h>
 #include <helpers/helpers.h>
 
+typedef struct {
+    int vtx_pos;
+    int vtx_tex0;
+    int pv;
+    int model;
+    int tex;
+    int alpha;
+} gl_shader_loc_t;
+
 struct gl_quad_t {
+    GLuint  vao;
     GLuint  vbo;
     GLuint  ibo;
     GLuint  shader;
     GLuint  tex;
     bool    own_shader;
     
-    struct {
-        int vtx_pos;
-        int vtx_tex0;
-        int pv;
-        int model;
-        int tex;
-        int alpha;
-    } loc;
+    gl_shader_loc_t loc;
     
+    vec4    uv;
     vec2    last_size;
 };
 
+// Sectors are re-tessellated every time they are drawn, with at most one segment every
+// SECTOR_MAX_STEP radians.
+#define SECTOR_MAX_STEP     (0.034906585f) // 2 degrees
+#define SECTOR_MAX_SEGMENTS (180)
+
+struct gl_sector_t {
+    GLuint  vao;
+    GLuint  vbo;
+    GLuint  shader;
+    GLuint  tex;
+    bool    own_shader;
+    
+    gl_shader_loc_t loc;
+};
+
 
 typedef struct {
     vec2    pos;
     vec2    tex;
 } vertex_t;
 
+// Program binary cache, used by the program constructors in gl.c. See glutils/progcache.h.
+uint64_t progcache_key(const char **sources, unsigned count);
+void progcache_prepare(GLuint prog);
+GLuint progcache_load(const char *name, uint64_t key);
+void progcache_store(const char *name, uint64_t key, GLuint prog);
+
 #endif /* ifndef _RENDERER_IMPL_H_ */
 
@@ -0,0 +1,210 @@
+/*===--------------------------------------------------------------------------------------------===
+ * loader.c
+ *
+ * Created by Amy Parent <amy@amyparent.com>
+ * Copyright (c) 2024 Laminar Research. All rights reserved
+ *
+ * Licensed under the MIT License
+ *===--------------------------------------------------------------------------------------------===
+*/
+#include <glutils/loader.h>
+#include <glutils/stb_image.h>
+#include <helpers/helpers.h>
+#include <helpers/thread.h>
+#include <stdio.h>
+
+#define LOADER_MAX_THREADS  (8)
+
+typedef struct {
+    gl_load_type_t  type;
+    char            *path;
+    const uint8_t   *src;
+    size_t          src_size;
+    uint8_t         *data;
+    size_t          size;
+    unsigned        w, h;
+    bool            failed;
+    bool            taken;
+} load_job_t;
+
+struct gl_loader_t {
+    unsigned    count;
+    unsigned    capacity;
+    load_job_t  *jobs;
+
+    thread_t    threads[LOADER_MAX_THREADS];
+    unsigned    thread_count;
+
+    // Everything below is shared with the workers.
+    mutex_t     lock;
+    unsigned    next;
+    unsigned    finished;
+    bool        cancel;
+};
+
+gl_loader_t *loader_new() {
+    gl_loader_t *loader = safe_calloc(1, sizeof(*loader));
+    mutex_init(&loader->lock);
+    return loader;
+}
+
+void loader_destroy(gl_loader_t *loader) {
+    ASSERT(loader);
+    mutex_enter(&loader->lock);
+    loader->cancel = true;
+    mutex_exit(&loader->lock);
+
+    for(unsigned i = 0; i < loader->thread_count; ++i)
+        thread_join(&loader->threads[i]);
+    mutex_destroy(&loader->lock);
+
+    for(unsigned i = 0; i < loader->count; ++i) {
+        free(loader->jobs[i].path);
+        free(loader->jobs[i].data);
+    }
+    free(loader->jobs);
+    free(loader);
+}
+
+int loader_add(gl_loader_t *loader, gl_load_type_t type, const char *path) {
+    return loader_add_mem(loader, type, path, NULL, 0);
+}
+
+int loader_add_mem(gl_loader_t *loader, gl_load_type_t type, const char *key, const uint8_t *src,
+                   size_t size) {
+    ASSERT(loader);
+    ASSERT(key);
+    ASSERT(!loader->thread_count);
+
+    for(unsigned i = 0; i < loader->count; ++i) {
+        if(loader->jobs[i].type == type && !strcmp(loader->jobs[i].path, key))
+            return i;
+    }
+
+    if(loader->count == loader->capacity) {
+        loader->capacity = loader->capacity ? loader->capacity * 2 : 8;
+        loader->jobs = safe_realloc(loader->jobs, loader->capacity * sizeof(*loader->jobs));
+    }
+    load_job_t *job = &loader->jobs[loader->count];
+    memset(job, 0, sizeof(*job));
+    job->type = type;
+    job->path = safe_strdup(key);
+    job->src = src;
+    job->src_size = size;
+    return loader->count++;
+}
+
+// Runs on the worker threads: nothing in here may log or call into X-Plane.
+static void run_job(load_job_t *job) {
+    if(job->type == LOAD_FILE && job->src) {
+        job->data = safe_malloc(job->src_size + 1);
+        memcpy(job->data, job->src, job->src_size);
+        job->data[job->src_size] = 0;
+        job->size = job->src_size;
+    } else if(job->type == LOAD_FILE) {
+        job->data = (uint8_t *)fs_read(job->path, &job->size);
+    } else {
+        int w = 0, h = 0, components = 0;
+        if(job->src)
+            job->data = stbi_load_from_memory(job->src, job->src_size, &w, &h, &components, 4);
+        else
+            job->data = stbi_load(job->path, &w, &h, &components, 4);
+        if(job->data && components != 4) {
+            free(job->data);
+            job->data = NULL;
+        }
+        job->w = w;
+        job->h = h;
+    }
+    job->failed = job->data == NULL;
+}
+
+static void worker(void *arg) {
+    gl_loader_t *loader = arg;
+    for(;;) {
+        mutex_enter(&loader->lock);
+        if(loader->cancel || loader->next >= loader->count) {
+            mutex_exit(&loader->lock);
+            return;
+        }
+        load_job_t *job = &loader->jobs[loader->next++];
+        mutex_exit(&loader->lock);
+
+        run_job(job);
+
+        mutex_enter(&loader->lock);
+        loader->finished += 1;
+        mutex_exit(&loader->lock);
+    }
+}
+
+void loader_start(gl_loader_t *loader, unsigned threads) {
+    ASSERT(loader);
+    ASSERT(!loader->thread_count);
+    threads = CLAMP(threads, 1, MIN(LOADER_MAX_THREADS, MAX(loader->count, 1)));
+
+    for(unsigned i = 0; i < threads; ++i) {
+        if(!thread_create(&loader->threads[loader->thread_count], worker, loader))
+            break;
+        loader->thread_count += 1;
+    }
+
+    // Without threads, we still get there, just the slow way.
+    if(!loader->thread_count) {
+        log_msg("unable to start loader threads, loading synchronously");
+        worker(loader);
+    }
+}
+
+bool loader_done(gl_loader_t *loader) {
+    ASSERT(loader);
+    mutex_enter(&loader->lock);
+    bool done = loader->finished == loader->count;
+    mutex_exit(&loader->lock);
+    return done;
+}
+
+const char *loader_path(const gl_loader_t *loader, int job) {
+    ASSERT(loader);
+    ASSERT(job >= 0 && (unsigned)job < loader->count);
+    return loader->jobs[job].path;
+}
+
+// Once loader_done() has returned true, the workers don't touch the jobs anymore.
+static load_job_t *loader_take(gl_loader_t *loader, int job_idx, gl_load_type_t type) {
+    ASSERT(loader);
+    if(job_idx < 0 || (unsigned)job_idx >= loader->count)
+        return NULL;
+    load_job_t *job = &loader->jobs[job_idx];
+    ASSERT(job->type == type);
+
+    if(job->taken)
+        return NULL;
+    job->taken = true;
+    if(job->failed) {
+        log_msg("unable to load `%s`", job->path);
+        return NULL;
+    }
+    return job;
+}
+
+uint8_t *loader_take_image(gl_loader_t *loader, int job_idx, unsigned *w, unsigned *h) {
+    load_job_t *job = loader_take(loader, job_idx, LOAD_IMAGE);
+    if(!job)
+        return NULL;
+    uint8_t *data = job->data;
+    job->data = NULL;
+    *w = job->w;
+    *h = job->h;
+    return data;
+}
+
+uint8_t *loader_take_file(gl_loader_t *loader, int job_idx, size_t *size) {
+    load_job_t *job = loader_take(loader, job_idx, LOAD_FILE);
+    if(!job)
+        return NULL;
+    uint8_t *data = job->data;
+    job->data = NULL;
+    *size = job->size;
+    return data;
+}
@@ -0,0 +1,91 @@
+/*===--------------------------------------------------------------------------------------------===
+ * pack.c
+ *
+ * Created by Amy Parent <amy@amyparent.com>
+ * Copyright (c) 2024 Laminar Research. All rights reserved
+ *
+ * Licensed under the MIT License
+ *===--------------------------------------------------------------------------------------------===
+*/
+#include <glutils/pack.h>
+#include <helpers/helpers.h>
+#include <stdlib.h>
+#include <string.h>
+
+static int cmp_height(const void *a, const void *b) {
+    const pack_img_t *img_a = *(const pack_img_t **)a;
+    const pack_img_t *img_b = *(const pack_img_t **)b;
+    return (int)img_b->h - (int)img_a->h;
+}
+
+static unsigned round_up(unsigned x, unsigned align) {
+    return (x + align - 1) / align * align;
+}
+
+// Bottom-left skyline packing: `sky` holds the outline left by the images placed so far, per
+// column.
+unsigned pack_images(pack_img_t *images, unsigned count, unsigned *width, unsigned padding,
+                     unsigned align) {
+    ASSERT(images || !count);
+    ASSERT(width);
+    ASSERT(align > 0 && padding % align == 0);
+    unsigned pad = padding;
+    for(unsigned i = 0; i < count; ++i) {
+        if(round_up(images[i].w + 2 * pad, align) > *width)
+            *width = round_up(images[i].w + 2 * pad, align);
+    }
+
+    pack_img_t **order = safe_calloc(MAX(count, 1), sizeof(*order));
+    for(unsigned i = 0; i < count; ++i)
+        order[i] = &images[i];
+    qsort(order, count, sizeof(*order), cmp_height);
+
+    unsigned *sky = safe_calloc(*width, sizeof(*sky));
+    unsigned height = 0;
+
+    for(unsigned i = 0; i < count; ++i) {
+        pack_img_t *img = order[i];
+        if(!img->data)
+            continue;
+        unsigned w = round_up(img->w + 2 * pad, align);
+        unsigned h = round_up(img->h + 2 * pad, align);
+
+        unsigned best_x = 0, best_y = UINT32_MAX;
+        for(unsigned x = 0; x + w <= *width; x += align) {
+            unsigned y = 0;
+            for(unsigned j = x; j < x + w; ++j)
+                y = MAX(y, sky[j]);
+            if(y < best_y) {
+                best_x = x;
+                best_y = y;
+            }
+        }
+
+        for(unsigned j = best_x; j < best_x + w; ++j)
+            sky[j] = best_y + h;
+        img->x = best_x + pad;
+        img->y = best_y + pad;
+        height = MAX(height, best_y + h);
+    }
+
+    free(sky);
+    free(order);
+    return height;
+}
+
+void pack_blit(uint8_t *pixels, unsigned width, const pack_img_t *img, unsigned padding) {
+    ASSERT(pixels);
+    ASSERT(img && img->data);
+    int pad = padding;
+    for(int y = -pad; y < (int)img->h + pad; ++y) {
+        int src_y = CLAMP(y, 0, (int)img->h - 1);
+        uint8_t *dst = pixels + ((img->y + y) * width + img->x) * 4;
+        const uint8_t *src = img->data + src_y * img->w * 4;
+
+        memcpy(dst, src, img->w * 4);
+        for(int x = 1; x <= pad; ++x) {
+            memcpy(dst - x * 4, src, 4);
+            memcpy(dst + (img->w + x - 1) * 4, src + (img->w - 1) * 4, 4);
+        }
+    }
+}
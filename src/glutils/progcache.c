@@ -0,0 +1,170 @@
+/*===--------------------------------------------------------------------------------------------===
+ * progcache.c
+ *
+ * Created by Amy Parent <amy@amyparent.com>
+ * Copyright (c) 2024 Laminar Research. All rights reserved
+ *
+ * Licensed under the MIT License
+ *===--------------------------------------------------------------------------------------------===
+*/
+#include <glutils/progcache.h>
+#include "glutils_impl.h"
+#include <stdint.h>
+
+#define PROGCACHE_MAGIC     (0x52504243u)
+#define PROGCACHE_VERSION   (1)
+
+#define FNV_OFFSET          (0xcbf29ce484222325ull)
+#define FNV_PRIME           (0x100000001b3ull)
+
+typedef struct {
+    uint32_t    magic;
+    uint32_t    version;
+    uint64_t    key;
+    uint32_t    format;
+    uint32_t    size;
+} progcache_header_t;
+
+static struct {
+    char        *dir;
+    bool        read;
+    uint64_t    driver;
+} cache = {0};
+
+// FNV-1a, including the terminating NUL so that {"ab", "c"} and {"a", "bc"} hash differently.
+static uint64_t hash_str(uint64_t hash, const char *str) {
+    do {
+        hash ^= (uint8_t)*str;
+        hash *= FNV_PRIME;
+    } while(*str++);
+    return hash;
+}
+
+static const char *gl_string(GLenum name) {
+    const char *str = (const char *)glGetString(name);
+    return str ? str : "";
+}
+
+uint64_t progcache_key(const char **sources, unsigned count) {
+    ASSERT(sources);
+    uint64_t key = cache.driver;
+    for(unsigned i = 0; i < count; ++i)
+        key = hash_str(key, sources[i]);
+    return key;
+}
+
+static char *progcache_path(const char *name) {
+    char fname[128];
+    snprintf(fname, sizeof(fname), "%s.bin", name);
+    return fs_make_path(cache.dir, fname, NULL);
+}
+
+void gl_progcache_init(const char *dir) {
+    ASSERT(dir);
+    gl_progcache_fini();
+    
+    GLint formats = 0;
+    if(GLEW_VERSION_4_1 || GLEW_ARB_get_program_binary)
+        glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+    if(formats <= 0) {
+        log_msg("program binaries are not supported, shaders will not be cached");
+        return;
+    }
+    
+    cache.dir = safe_strdup(dir);
+    cache.read = true;
+    cache.driver = FNV_OFFSET;
+    cache.driver = hash_str(cache.driver, gl_string(GL_VENDOR));
+    cache.driver = hash_str(cache.driver, gl_string(GL_RENDERER));
+    cache.driver = hash_str(cache.driver, gl_string(GL_VERSION));
+}
+
+void gl_progcache_fini() {
+    free(cache.dir);
+    cache.dir = NULL;
+    cache.read = false;
+}
+
+void gl_progcache_invalidate() {
+    cache.read = false;
+}
+
+void progcache_prepare(GLuint prog) {
+    if(cache.dir)
+        glProgramParameteri(prog, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+}
+
+GLuint progcache_load(const char *name, uint64_t key) {
+    ASSERT(name);
+    if(!cache.dir || !cache.read)
+        return 0;
+    
+    char *path = progcache_path(name);
+    FILE *f = fopen(path, "rb");
+    free(path);
+    if(!f)
+        return 0;
+    
+    GLuint prog = 0;
+    progcache_header_t header;
+    if(fread(&header, sizeof(header), 1, f) == 1
+       && header.magic == PROGCACHE_MAGIC
+       && header.version == PROGCACHE_VERSION
+       && header.key == key
+       && header.size > 0) {
+        
+        void *data = safe_malloc(header.size);
+        if(fread(data, header.size, 1, f) == 1) {
+            prog = glCreateProgram();
+            glProgramBinary(prog, header.format, data, header.size);
+            
+            // Drivers can refuse binaries they wrote themselves. The caller then builds the
+            // program from source, which replaces the stale binary.
+            GLint is_linked = GL_FALSE;
+            glGetProgramiv(prog, GL_LINK_STATUS, &is_linked);
+            if(is_linked != GL_TRUE) {
+                glDeleteProgram(prog);
+                prog = 0;
+            }
+        }
+        free(data);
+    }
+    fclose(f);
+    return prog;
+}
+
+void progcache_store(const char *name, uint64_t key, GLuint prog) {
+    ASSERT(name);
+    if(!cache.dir || !prog)
+        return;
+    
+    GLint size = 0;
+    glGetProgramiv(prog, GL_PROGRAM_BINARY_LENGTH, &size);
+    if(size <= 0)
+        return;
+    
+    GLenum format = 0;
+    void *data = safe_malloc(size);
+    glGetProgramBinary(prog, size, &size, &format, data);
+    
+    progcache_header_t header = {
+        .magic = PROGCACHE_MAGIC,
+        .version = PROGCACHE_VERSION,
+        .key = key,
+        .format = format,
+        .size = size,
+    };
+    
+    char *path = progcache_path(name);
+    FILE *f = fopen(path, "wb");
+    if(f) {
+        bool ok = fwrite(&header, sizeof(header), 1, f) == 1 && fwrite(data, size, 1, f) == 1;
+        fclose(f);
+        if(!ok)
+            remove(path);
+    } else {
+        log_msg("cannot write program binary `%s`", path);
+    }
+    free(path);
+    free(data);
+}
@@ -0,0 +1,133 @@
+/*===--------------------------------------------------------------------------------------------===
+ * program.c
+ *
+ * Created by Amy Parent <amy@amyparent.com>
+ * Copyright (c) 2024 Laminar Research. All rights reserved
+ *
+ * Licensed under the MIT License
+ *===--------------------------------------------------------------------------------------------===
+*/
+#include <glutils/program.h>
+#include <helpers/helpers.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+struct gl_block_t {
+    const gl_block_desc_t   *desc;
+    GLuint                  ubo;
+    void                    *data;
+    unsigned                gen;
+};
+
+gl_block_t *gl_block_new(const gl_block_desc_t *desc, bool use_ubo) {
+    ASSERT(desc);
+    ASSERT(desc->count <= GL_BLOCK_MAX_MEMBERS);
+
+    gl_block_t *block = safe_calloc(1, sizeof(*block));
+    block->desc = desc;
+    block->data = safe_calloc(1, desc->size);
+
+    if(use_ubo) {
+        glGenBuffers(1, &block->ubo);
+        glBindBuffer(GL_UNIFORM_BUFFER, block->ubo);
+        glBufferData(GL_UNIFORM_BUFFER, desc->size, block->data, GL_DYNAMIC_DRAW);
+        glBindBuffer(GL_UNIFORM_BUFFER, 0);
+        CHECK_GL();
+    }
+    return block;
+}
+
+void gl_block_destroy(gl_block_t *block) {
+    ASSERT(block);
+    if(block->ubo)
+        glDeleteBuffers(1, &block->ubo);
+    free(block->data);
+    free(block);
+}
+
+void gl_block_update(gl_block_t *block, const void *data) {
+    ASSERT(block);
+    ASSERT(data);
+
+    // Generation 0 is what programs start with, so the first update always goes through.
+    if(block->gen == 0 || memcmp(block->data, data, block->desc->size)) {
+        memcpy(block->data, data, block->desc->size);
+        block->gen += 1;
+
+        if(block->ubo) {
+            glBindBuffer(GL_UNIFORM_BUFFER, block->ubo);
+            glBufferSubData(GL_UNIFORM_BUFFER, 0, block->desc->size, block->data);
+            glBindBuffer(GL_UNIFORM_BUFFER, 0);
+        }
+    }
+
+    // The sim might have used the binding point since our last update.
+    if(block->ubo)
+        glBindBufferBase(GL_UNIFORM_BUFFER, block->desc->binding, block->ubo);
+    CHECK_GL();
+}
+
+void gl_program_init(gl_program_t *prog, GLuint id, const gl_block_t *block,
+                     const char **names, unsigned count) {
+    ASSERT(prog);
+    ASSERT(count <= GL_PROGRAM_MAX_UNIFORMS);
+
+    prog->id = id;
+    prog->block = block;
+    prog->block_gen = 0;
+    for(unsigned i = 0; i < GL_PROGRAM_MAX_UNIFORMS; ++i)
+        prog->loc[i] = -1;
+    for(unsigned i = 0; i < GL_BLOCK_MAX_MEMBERS; ++i)
+        prog->block_loc[i] = -1;
+
+    if(!id)
+        return;
+
+    for(unsigned i = 0; i < count; ++i)
+        prog->loc[i] = glGetUniformLocation(id, names[i]);
+
+    // With uniform buffers, the shaders bind the block themselves (layout(binding = N)).
+    if(!block || block->ubo)
+        return;
+
+    const gl_block_desc_t *desc = block->desc;
+    for(unsigned i = 0; i < desc->count; ++i) {
+        char name[64];
+        snprintf(name, sizeof(name), "%s.%s", desc->name, desc->members[i].name);
+        prog->block_loc[i] = glGetUniformLocation(id, name);
+    }
+}
+
+void gl_program_fini(gl_program_t *prog) {
+    ASSERT(prog);
+    if(prog->id)
+        gl_delete_program(prog->id);
+    prog->id = 0;
+}
+
+void gl_program_use(gl_program_t *prog) {
+    ASSERT(prog);
+    gl_use_program(prog->id);
+
+    const gl_block_t *block = prog->block;
+    if(!prog->id || !block || block->ubo || prog->block_gen == block->gen)
+        return;
+
+    const gl_block_desc_t *desc = block->desc;
+    for(unsigned i = 0; i < desc->count; ++i) {
+        if(prog->block_loc[i] < 0)
+            continue;
+        const float *val = (const float *)((const char *)block->data + desc->members[i].offset);
+        switch(desc->members[i].type) {
+        case GL_BLOCK_FLOAT:
+            glUniform1f(prog->block_loc[i], val[0]);
+            break;
+        case GL_BLOCK_VEC2:
+            glUniform2f(prog->block_loc[i], val[0], val[1]);
+            break;
+        }
+    }
+    prog->block_gen = block->gen;
+    CHECK_GL();
+}
@@ -9,7 +9,9 @@
 #include "glutils_impl.h"
 #include <XPLMGraphics.h>
 #include <helpers/helpers.h>
+#include <math.h>
 #include <stddef.h>
+#include <string.h>
 
 static const char *vert_shader =
     "#version 120\n"
@@ -33,20 +35,74 @@ static const char *frag_shader =
     "   gl_FragColor.a *= alpha;\n"
     "}\n";
 
-static void quad_find_shader_uniforms(gl_quad_t *quad) {
-    glUseProgram(quad->shader);
-    quad->loc.pv = glGetUniformLocation(quad->shader, "pv");
-    quad->loc.model = glGetUniformLocation(quad->shader, "model");
-    quad->loc.tex = glGetUniformLocation(quad->shader, "tex");
-    quad->loc.alpha = glGetUniformLocation(quad->shader, "alpha");
+static void find_shader_uniforms(GLuint shader, gl_shader_loc_t *loc) {
+    loc->pv = glGetUniformLocation(shader, "pv");
+    loc->model = glGetUniformLocation(shader, "model");
+    loc->tex = glGetUniformLocation(shader, "tex");
+    loc->alpha = glGetUniformLocation(shader, "alpha");
+    
+    loc->vtx_pos = glGetAttribLocation(shader, "vtx_pos");
+    loc->vtx_tex0 = glGetAttribLocation(shader, "vtx_tex0");
+    
+    // Everything we draw samples its texture from unit 0, so this only needs doing once.
+    gl_use_program(shader);
+    glUniform1i(loc->tex, 0);
+}
+
+// Describes the vertex layout for the current shader. With vertex array objects this is recorded
+// once per shader, otherwise it happens on every draw.
+static void setup_attribs(const gl_shader_loc_t *loc, GLuint vbo, GLuint ibo) {
+    glBindBuffer(GL_ARRAY_BUFFER, vbo);
+    if(ibo)
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ibo);
     
-    quad->loc.vtx_pos = glGetAttribLocation(quad->shader, "vtx_pos");
-    quad->loc.vtx_tex0 = glGetAttribLocation(quad->shader, "vtx_tex0");
-    glUseProgram(0);
+    if(loc->vtx_pos >= 0) {
+        glEnableVertexAttribArray(loc->vtx_pos);
+        glVertexAttribPointer(loc->vtx_pos, 2, GL_FLOAT, GL_FALSE, sizeof(vertex_t), (void *)offsetof(vertex_t, pos));
+    }
+    if(loc->vtx_tex0 >= 0) {
+        glEnableVertexAttribArray(loc->vtx_tex0);
+        glVertexAttribPointer(loc->vtx_tex0, 2, GL_FLOAT, GL_FALSE, sizeof(vertex_t), (void *)offsetof(vertex_t, tex));
+    }
+}
+
+static void disable_attribs(const gl_shader_loc_t *loc) {
+    if(loc->vtx_pos >= 0)
+        glDisableVertexAttribArray(loc->vtx_pos);
+    if(loc->vtx_tex0 >= 0)
+        glDisableVertexAttribArray(loc->vtx_tex0);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+// (Re-)creates the vertex array object for a mesh, since the attribute locations depend on the
+// shader. Returns 0 when vertex array objects aren't supported.
+static GLuint update_vao(GLuint vao, const gl_shader_loc_t *loc, GLuint vbo, GLuint ibo) {
+    if(!gl_has_vao())
+        return 0;
+    
+    // Unbind first, so the state cache never points to a deleted (and maybe reused) name.
+    gl_bind_vao(0);
+    if(vao)
+        glDeleteVertexArrays(1, &vao);
+    
+    glGenVertexArrays(1, &vao);
+    gl_bind_vao(vao);
+    setup_attribs(loc, vbo, ibo);
+    gl_bind_vao(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    CHECK_GL();
+    return vao;
+}
+
+static void quad_find_shader_uniforms(gl_quad_t *quad) {
+    find_shader_uniforms(quad->shader, &quad->loc);
+    quad->vao = update_vao(quad->vao, &quad->loc, quad->vbo, quad->ibo);
 }
 
 void quad_init(gl_quad_t *quad, unsigned tex, unsigned shader) {
     quad->last_size[0] = NAN;
+    glm_vec4_copy((vec4){0, 0, 1, 1}, quad->uv);
     
     quad->tex = tex;
     if(shader) {
@@ -56,30 +112,36 @@ void quad_init(gl_quad_t *quad, unsigned tex, unsigned shader) {
         quad->shader = gl_program_new(vert_shader, frag_shader);
         quad->own_shader = true;
     }
-    quad_find_shader_uniforms(quad);
     
     glGenBuffers(1, &quad->vbo);
     glGenBuffers(1, &quad->ibo);
     
+    // The index buffer must not end up in whichever vertex array object is bound.
     static const GLuint indices[] = {0, 2, 1, 0, 3, 2};
+    gl_bind_vao(0);
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, quad->ibo);
     glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(indices), indices, GL_STATIC_DRAW);
-    
-
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
-    XPLMBindTexture2d(0, 0);
+    
+    quad_find_shader_uniforms(quad);
 }
 
 void quad_set_tex(gl_quad_t *quad, unsigned tex) {
     quad->tex = tex;
 }
 
+void quad_set_uv(gl_quad_t *quad, const vec4 uv) {
+    if(!memcmp(quad->uv, uv, sizeof(quad->uv)))
+        return;
+    memcpy(quad->uv, uv, sizeof(quad->uv));
+    quad->last_size[0] = NAN;
+}
+
 
 void quad_set_shader(gl_quad_t *quad, unsigned shader) {
     GLuint old_shader = quad->shader;
     if(quad->own_shader)
-        glDeleteProgram(quad->shader);
+        gl_delete_program(quad->shader);
     quad->shader = shader;
     quad->own_shader = false;
     
@@ -90,7 +152,11 @@ void quad_set_shader(gl_quad_t *quad, unsigned shader) {
 
 void quad_fini(gl_quad_t *quad) {
     if(quad->own_shader)
-        glDeleteProgram(quad->shader);
+        gl_delete_program(quad->shader);
+    if(quad->vao) {
+        gl_bind_vao(0);
+        glDeleteVertexArrays(1, &quad->vao);
+    }
     glDeleteBuffers(1, &quad->vbo);
     glDeleteBuffers(1, &quad->ibo);
 }
@@ -114,26 +180,28 @@ static void prepare_vertices(gl_quad_t *quad, vec2 size) {
     if(vec2_eq(quad->last_size, size))
         return;
     vertex_t vert[4];
+    float u0 = quad->uv[0], u1 = quad->uv[0] + quad->uv[2];
+    float v0 = quad->uv[1], v1 = quad->uv[1] + quad->uv[3];
     
     vert[0].pos[0] = 0;
     vert[0].pos[1] = 0;
-    vert[0].tex[0] = 0;
-    vert[0].tex[1] = 0;
+    vert[0].tex[0] = u0;
+    vert[0].tex[1] = v0;
 
     vert[1].pos[0] = size[0];
     vert[1].pos[1] = 0;
-    vert[1].tex[0] = 1;
-    vert[1].tex[1] = 0;
+    vert[1].tex[0] = u1;
+    vert[1].tex[1] = v0;
 
     vert[2].pos[0] = size[0];
     vert[2].pos[1] = size[1];
-    vert[2].tex[0] = 1;
-    vert[2].tex[1] = 1;
+    vert[2].tex[0] = u1;
+    vert[2].tex[1] = v1;
 
     vert[3].pos[0] = 0;
     vert[3].pos[1] = size[1];
-    vert[3].tex[0] = 0;
-    vert[3].tex[1] = 1;
+    vert[3].tex[0] = u0;
+    vert[3].tex[1] = v1;
     
     glBindBuffer(GL_ARRAY_BUFFER, quad->vbo);
     glBufferData(GL_ARRAY_BUFFER, sizeof(vert), vert, GL_STATIC_DRAW);
@@ -141,43 +209,128 @@ static void prepare_vertices(gl_quad_t *quad, vec2 size) {
     
     glm_vec2_copy(size, quad->last_size);
 }
+static void draw_begin(GLuint shader, const gl_shader_loc_t *loc, GLuint tex,
+                       GLuint vao, GLuint vbo, GLuint ibo, mat4 pvm, mat4 model, float alpha) {
+    // XPLMBindTexture2d already skips redundant binds.
+    XPLMBindTexture2d(tex, 0);
+    gl_use_program(shader);
+    
+    if(vao)
+        gl_bind_vao(vao);
+    else
+        setup_attribs(loc, vbo, ibo);
+    
+    glUniformMatrix4fv(loc->pv, 1, GL_FALSE, (float *)pvm);
+    glUniformMatrix4fv(loc->model, 1, GL_FALSE, (float *)model);
+    glUniform1f(loc->alpha, alpha);
+}
+
+// Nothing is unbound when we have vertex array objects: gl_state_reset() takes care of it when
+// control goes back to the sim.
+static void draw_end(const gl_shader_loc_t *loc, GLuint vao) {
+    if(!vao)
+        disable_attribs(loc);
+    CHECK_GL();
+}
+
 void quad_render(mat4 pvm, gl_quad_t *quad, vec2 pos, vec2 size, float rot, float alpha) {
     ASSERT(quad);
     ASSERT(pvm);
     
-    XPLMBindTexture2d(quad->tex, 0);
-    
     prepare_vertices(quad, size);
     
-    glUseProgram(quad->shader);
-    glBindBuffer(GL_ARRAY_BUFFER, quad->vbo);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, quad->ibo);
-    
-    glEnableVertexAttribArray(quad->loc.vtx_pos);
-    glEnableVertexAttribArray(quad->loc.vtx_tex0);
-    
-    glVertexAttribPointer(quad->loc.vtx_pos, 2, GL_FLOAT, GL_FALSE, sizeof(vertex_t), (void *)offsetof(vertex_t, pos));
-    glVertexAttribPointer(quad->loc.vtx_tex0, 2, GL_FLOAT, GL_FALSE, sizeof(vertex_t), (void *)offsetof(vertex_t, tex));
-    
     mat4 model;
 	glm_mat4_identity(model);
     glm_translate(model, (vec3){pos[0], pos[1], 0});
     glm_rotate_at(model, (vec3){size[0]/2.f, size[1]/2.f, 0}, glm_rad(rot), (vec3){0, 0, 1});
     
-    glUniformMatrix4fv(quad->loc.pv, 1, GL_FALSE, (float *)pvm);
-    glUniformMatrix4fv(quad->loc.model, 1, GL_FALSE, (float *)model);
-    glUniform1f(quad->loc.alpha, alpha);
-    glUniform1i(quad->loc.tex, 0);
+    draw_begin(quad->shader, &quad->loc, quad->tex, quad->vao, quad->vbo, quad->ibo, pvm, model, alpha);
     glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
-    CHECK_GL();
+    draw_end(&quad->loc, quad->vao);
+}
+
+// MARK: - Sectors
+
+gl_sector_t *sector_new(unsigned tex, unsigned shader) {
+    gl_sector_t *sector = safe_calloc(1, sizeof(*sector));
     
-    glDisableVertexAttribArray(quad->loc.vtx_pos);
-    glDisableVertexAttribArray(quad->loc.vtx_tex0);
+    sector->tex = tex;
+    if(shader) {
+        sector->shader = shader;
+        sector->own_shader = false;
+    } else {
+        sector->shader = gl_program_new(vert_shader, frag_shader);
+        sector->own_shader = true;
+    }
+    glGenBuffers(1, &sector->vbo);
+    find_shader_uniforms(sector->shader, &sector->loc);
+    sector->vao = update_vao(0, &sector->loc, sector->vbo, 0);
+    return sector;
+}
+
+void sector_set_tex(gl_sector_t *sector, unsigned tex) {
+    sector->tex = tex;
+}
+
+void sector_set_shader(gl_sector_t *sector, unsigned shader) {
+    GLuint old_shader = sector->shader;
+    if(sector->own_shader)
+        gl_delete_program(sector->shader);
+    sector->shader = shader;
+    sector->own_shader = false;
     
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
-    XPLMBindTexture2d(0, 0);
-    glUseProgram(0);
-    CHECK_GL();
+    if(old_shader != sector->shader) {
+        find_shader_uniforms(sector->shader, &sector->loc);
+        sector->vao = update_vao(sector->vao, &sector->loc, sector->vbo, 0);
+    }
+}
+
+void sector_destroy(gl_sector_t *sector) {
+    if(sector->own_shader)
+        gl_delete_program(sector->shader);
+    if(sector->vao) {
+        gl_bind_vao(0);
+        glDeleteVertexArrays(1, &sector->vao);
+    }
+    glDeleteBuffers(1, &sector->vbo);
+    free(sector);
+}
+
+void sector_render(mat4 pvm, gl_sector_t *sector, vec2 size, vec2 center, float radius,
+                   float start, float end, float alpha) {
+    ASSERT(sector);
+    ASSERT(pvm);
+    
+    if(end <= start)
+        return;
+    
+    // The rim is pushed out so the chords between rim vertices still cover the arc, by the same
+    // amount whatever the segment count, so that consecutive sectors share their edges exactly.
+    unsigned segments = (unsigned)ceilf((end - start) / SECTOR_MAX_STEP);
+    segments = CLAMP(segments, 1u, SECTOR_MAX_SEGMENTS);
+    float rim = radius / cosf(SECTOR_MAX_STEP / 2.f);
+    
+    vertex_t vert[SECTOR_MAX_SEGMENTS + 2];
+    vert[0].pos[0] = center[0];
+    vert[0].pos[1] = center[1];
+    for(unsigned i = 0; i <= segments; ++i) {
+        float angle = i == segments ? end : start + (end - start) * (float)i / (float)segments;
+        vert[i + 1].pos[0] = center[0] + rim * sinf(angle);
+        vert[i + 1].pos[1] = center[1] + rim * cosf(angle);
+    }
+    for(unsigned i = 0; i < segments + 2; ++i) {
+        vert[i].tex[0] = vert[i].pos[0] / size[0];
+        vert[i].tex[1] = vert[i].pos[1] / size[1];
+    }
+    
+    mat4 model;
+    glm_mat4_identity(model);
+    
+    glBindBuffer(GL_ARRAY_BUFFER, sector->vbo);
+    glBufferData(GL_ARRAY_BUFFER, (segments + 2) * sizeof(vertex_t), vert, GL_STREAM_DRAW);
+    
+    draw_begin(sector->shader, &sector->loc, sector->tex, sector->vao, sector->vbo, 0, pvm, model, alpha);
+    glDrawArrays(GL_TRIANGLE_FAN, 0, segments + 2);
+    draw_end(&sector->loc, sector->vao);
 }
 
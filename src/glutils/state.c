@@ -0,0 +1,65 @@
+/*===--------------------------------------------------------------------------------------------===
+ * state.c
+ *
+ * Created by Amy Parent <amy@amyparent.com>
+ * Copyright (c) 2024 Laminar Research. All rights reserved
+ *
+ * Licensed under the MIT License
+ *===--------------------------------------------------------------------------------------------===
+*/
+#include <glutils/gl.h>
+#include <XPLMGraphics.h>
+
+// Names GL never hands out, which the next bind can't match.
+#define GL_STATE_UNKNOWN    (~0u)
+
+static struct {
+    GLuint  program;
+    GLuint  vao;
+} state = {GL_STATE_UNKNOWN, GL_STATE_UNKNOWN};
+
+bool gl_has_vao() {
+    return GLEW_VERSION_3_0 || GLEW_ARB_vertex_array_object;
+}
+
+void gl_state_invalidate() {
+    state.program = GL_STATE_UNKNOWN;
+    state.vao = GL_STATE_UNKNOWN;
+    gl_debug_begin();
+}
+
+void gl_state_reset() {
+    if(gl_has_vao())
+        glBindVertexArray(0);
+    glUseProgram(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+    XPLMBindTexture2d(0, 0);
+
+    state.program = 0;
+    state.vao = 0;
+    gl_debug_end();
+}
+
+void gl_use_program(GLuint program) {
+    if(state.program == program)
+        return;
+    glUseProgram(program);
+    state.program = program;
+}
+
+void gl_delete_program(GLuint program) {
+    // The name can be handed out again, and the new program would then never get bound.
+    if(state.program == program)
+        state.program = GL_STATE_UNKNOWN;
+    glDeleteProgram(program);
+}
+
+void gl_bind_vao(GLuint vao) {
+    if(state.vao == vao)
+        return;
+    // Without vertex array objects, only "unbinding" them can be asked for.
+    if(gl_has_vao())
+        glBindVertexArray(vao);
+    state.vao = vao;
+}
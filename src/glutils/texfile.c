@@ -0,0 +1,186 @@
+/*===--------------------------------------------------------------------------------------------===
+ * texfile.c
+ *
+ * Created by Amy Parent <amy@amyparent.com>
+ * Copyright (c) 2024 Laminar Research. All rights reserved
+ *
+ * Licensed under the MIT License
+ *===--------------------------------------------------------------------------------------------===
+*/
+#include <glutils/texfile.h>
+#include <helpers/helpers.h>
+#include <string.h>
+
+bool texfile_is_compressed(texfile_format_t format) {
+    return format == TEXFILE_BC1 || format == TEXFILE_BC3;
+}
+
+size_t texfile_level_size(texfile_format_t format, unsigned width, unsigned height) {
+    size_t blocks = (size_t)((width + 3) / 4) * ((height + 3) / 4);
+    switch(format) {
+    case TEXFILE_RGBA8: return (size_t)width * height * 4;
+    case TEXFILE_BC1: return blocks * 8;
+    case TEXFILE_BC3: return blocks * 16;
+    }
+    return 0;
+}
+
+bool texfile_parse(const uint8_t *data, size_t size, texfile_t *file) {
+    ASSERT(data || !size);
+    ASSERT(file);
+    memset(file, 0, sizeof(*file));
+    
+    texfile_header_t header;
+    if(size < sizeof(header))
+        return false;
+    memcpy(&header, data, sizeof(header));
+    if(header.magic != TEXFILE_MAGIC || header.version != TEXFILE_VERSION)
+        return false;
+    if(header.format > TEXFILE_BC3 || !header.width || !header.height)
+        return false;
+    if(!header.levels || header.levels > TEXFILE_MAX_LEVELS)
+        return false;
+    
+    file->format = header.format;
+    file->width = header.width;
+    file->height = header.height;
+    file->levels = header.levels;
+    
+    size_t offset = sizeof(header);
+    size_t rects_size = header.rect_count * sizeof(texfile_rect_t);
+    if(rects_size > size - offset)
+        return false;
+    file->rect_count = header.rect_count;
+    file->rects = data + offset;
+    offset += texfile_align(rects_size);
+    
+    size_t glyphs_size = header.glyph_count * sizeof(texfile_glyph_t);
+    if(header.glyph_count && header.glyph_count != header.rect_count)
+        return false;
+    if(offset > size || glyphs_size > size - offset)
+        return false;
+    file->glyph_count = header.glyph_count;
+    file->glyphs = data + offset;
+    file->font_size = header.font_size;
+    offset += texfile_align(glyphs_size);
+    
+    for(unsigned i = 0; i < file->levels; ++i) {
+        texfile_level_t level;
+        if(offset > size || size - offset < sizeof(level))
+            return false;
+        memcpy(&level, data + offset, sizeof(level));
+        offset += sizeof(level);
+        
+        size_t expected = texfile_level_size(file->format, texfile_level_dim(file->width, i),
+                                             texfile_level_dim(file->height, i));
+        if(level.size != expected || level.size > size - offset)
+            return false;
+        file->level_data[i] = data + offset;
+        file->level_size[i] = level.size;
+        offset += texfile_align(level.size);
+    }
+    return true;
+}
+
+void texfile_get_rect(const texfile_t *file, unsigned idx, texfile_rect_t *rect) {
+    ASSERT(file);
+    ASSERT(idx < file->rect_count);
+    ASSERT(rect);
+    memcpy(rect, file->rects + idx * sizeof(*rect), sizeof(*rect));
+    rect->name[TEXFILE_NAME_MAX - 1] = '\0';
+}
+
+void texfile_get_glyph(const texfile_t *file, unsigned idx, texfile_glyph_t *glyph) {
+    ASSERT(file);
+    ASSERT(idx < file->glyph_count);
+    ASSERT(glyph);
+    memcpy(glyph, file->glyphs + idx * sizeof(*glyph), sizeof(*glyph));
+}
+
+static uint16_t read_u16(const uint8_t *data) {
+    return data[0] | (data[1] << 8);
+}
+
+static void rgb565(uint16_t c, unsigned rgb[3]) {
+    unsigned r = (c >> 11) & 0x1f, g = (c >> 5) & 0x3f, b = c & 0x1f;
+    rgb[0] = (r << 3) | (r >> 2);
+    rgb[1] = (g << 2) | (g >> 4);
+    rgb[2] = (b << 3) | (b >> 2);
+}
+
+// Decodes the colour half of a block into a 4x4 RGBA block. BC3 blocks always use four colours,
+// BC1 blocks use three and transparent black when the first endpoint isn't the larger one.
+static void decode_color(const uint8_t *block, bool bc1, uint8_t out[16][4]) {
+    uint16_t c0 = read_u16(block), c1 = read_u16(block + 2);
+    unsigned e[2][3], palette[4][4];
+    rgb565(c0, e[0]);
+    rgb565(c1, e[1]);
+    for(int c = 0; c < 3; ++c) {
+        palette[0][c] = e[0][c];
+        palette[1][c] = e[1][c];
+        if(!bc1 || c0 > c1) {
+            palette[2][c] = (2 * e[0][c] + e[1][c]) / 3;
+            palette[3][c] = (e[0][c] + 2 * e[1][c]) / 3;
+        } else {
+            palette[2][c] = (e[0][c] + e[1][c]) / 2;
+            palette[3][c] = 0;
+        }
+    }
+    for(int i = 0; i < 4; ++i)
+        palette[i][3] = 255;
+    if(bc1 && c0 <= c1)
+        palette[3][3] = 0;
+
+    for(int i = 0; i < 16; ++i) {
+        unsigned idx = (block[4 + i / 4] >> ((i % 4) * 2)) & 3;
+        for(int c = 0; c < 4; ++c)
+            out[i][c] = palette[idx][c];
+    }
+}
+
+static void decode_alpha(const uint8_t *block, uint8_t out[16][4]) {
+    unsigned a0 = block[0], a1 = block[1], palette[8] = {a0, a1};
+    for(unsigned i = 2; i < 8; ++i) {
+        if(a0 > a1)
+            palette[i] = ((8 - i) * a0 + (i - 1) * a1) / 7;
+        else
+            palette[i] = i == 6 ? 0 : i == 7 ? 255 : ((6 - i) * a0 + (i - 1) * a1) / 5;
+    }
+
+    uint64_t bits = 0;
+    for(int i = 0; i < 6; ++i)
+        bits |= (uint64_t)block[2 + i] << (8 * i);
+    for(int i = 0; i < 16; ++i)
+        out[i][3] = palette[(bits >> (3 * i)) & 7];
+}
+
+uint8_t *texfile_decode(const texfile_t *file, unsigned level) {
+    ASSERT(file);
+    ASSERT(level < file->levels);
+    ASSERT(texfile_is_compressed(file->format));
+    
+    unsigned w = texfile_level_dim(file->width, level);
+    unsigned h = texfile_level_dim(file->height, level);
+    size_t block_size = file->format == TEXFILE_BC1 ? 8 : 16;
+    const uint8_t *block = file->level_data[level];
+    uint8_t *pixels = safe_calloc((size_t)w * h, 4);
+    
+    for(unsigned by = 0; by < h; by += 4) {
+        for(unsigned bx = 0; bx < w; bx += 4) {
+            uint8_t out[16][4];
+            if(file->format == TEXFILE_BC1) {
+                decode_color(block, true, out);
+            } else {
+                decode_color(block + 8, false, out);
+                decode_alpha(block, out);
+            }
+            block += block_size;
+            
+            for(unsigned y = by; y < MIN(by + 4, h); ++y) {
+                for(unsigned x = bx; x < MIN(bx + 4, w); ++x)
+                    memcpy(pixels + (y * w + x) * 4, out[(y - by) * 4 + (x - bx)], 4);
+            }
+        }
+    }
+    return pixels;
+}
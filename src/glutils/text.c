@@ -0,0 +1,120 @@
+/*===--------------------------------------------------------------------------------------------===
+ * text.c
+ *
+ * Created by Amy Parent <amy@amyparent.com>
+ * Copyright (c) 2024 Laminar Research. All rights reserved
+ *
+ * Licensed under the MIT License
+ *===--------------------------------------------------------------------------------------------===
+*/
+#include <glutils/text.h>
+#include <glutils/texfile.h>
+#include <helpers/helpers.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct {
+    uint32_t    codepoint;
+    float       advance;
+    vec2        offset;
+    vec2        size;
+    vec4        uv;
+} glyph_t;
+
+struct gl_font_t {
+    GLuint      tex;
+    float       size;
+    unsigned    count;
+    glyph_t     *glyphs;
+};
+
+static int cmp_codepoint(const void *a, const void *b) {
+    uint32_t cp_a = ((const glyph_t *)a)->codepoint;
+    uint32_t cp_b = ((const glyph_t *)b)->codepoint;
+    return cp_a < cp_b ? -1 : cp_a > cp_b;
+}
+
+gl_font_t *font_load(const uint8_t *data, size_t size) {
+    texfile_t file;
+    if(!texfile_parse(data, size, &file) || !file.glyph_count || file.font_size <= 0.f) {
+        log_msg("invalid baked font");
+        return NULL;
+    }
+
+    gl_font_t *font = safe_calloc(1, sizeof(*font));
+    font->size = file.font_size;
+    font->count = file.glyph_count;
+    font->glyphs = safe_calloc(font->count, sizeof(*font->glyphs));
+    for(unsigned i = 0; i < font->count; ++i) {
+        texfile_rect_t rect;
+        texfile_glyph_t info;
+        texfile_get_rect(&file, i, &rect);
+        texfile_get_glyph(&file, i, &info);
+
+        glyph_t *glyph = &font->glyphs[i];
+        glyph->codepoint = info.codepoint;
+        glyph->advance = info.advance;
+        glyph->offset[0] = info.x_off;
+        glyph->offset[1] = info.y_off;
+        glyph->size[0] = rect.w;
+        glyph->size[1] = rect.h;
+        glyph->uv[0] = (float)rect.x / (float)file.width;
+        glyph->uv[1] = (float)rect.y / (float)file.height;
+        glyph->uv[2] = (float)rect.w / (float)file.width;
+        glyph->uv[3] = (float)rect.h / (float)file.height;
+    }
+    qsort(font->glyphs, font->count, sizeof(*font->glyphs), cmp_codepoint);
+
+    font->tex = gl_tex_new_texfile(&file);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    CHECK_GL();
+    return font;
+}
+
+void font_destroy(gl_font_t *font) {
+    ASSERT(font);
+    glDeleteTextures(1, &font->tex);
+    free(font->glyphs);
+    free(font);
+}
+
+// Decodes the character at `*str` and moves past it. Malformed sequences come out as garbage, but
+// never read past the end of the string.
+static uint32_t utf8_next(const char **str) {
+    const uint8_t *c = (const uint8_t *)*str;
+    uint32_t cp = *c++;
+    int extra = cp >= 0xf0 ? 3 : cp >= 0xe0 ? 2 : cp >= 0xc0 ? 1 : 0;
+    if(extra)
+        cp &= 0x3f >> extra;
+    for(; extra && (*c & 0xc0) == 0x80; --extra)
+        cp = (cp << 6) | (*c++ & 0x3f);
+    *str = (const char *)c;
+    return cp;
+}
+
+static const glyph_t *font_find(const gl_font_t *font, uint32_t codepoint) {
+    glyph_t key = {.codepoint = codepoint};
+    return bsearch(&key, font->glyphs, font->count, sizeof(*font->glyphs), cmp_codepoint);
+}
+
+float font_draw(const gl_font_t *font, gl_batch_t *batch, vec2 pos, float size, const char *str) {
+    ASSERT(font);
+    ASSERT(batch);
+    ASSERT(str);
+
+    float scale = size / font->size;
+    float x = pos[0];
+    while(*str) {
+        const glyph_t *glyph = font_find(font, utf8_next(&str));
+        if(!glyph)
+            continue;
+        if(glyph->size[0] > 0.f) {
+            vec2 at = {x + glyph->offset[0] * scale, pos[1] + glyph->offset[1] * scale};
+            vec2 extent = {glyph->size[0] * scale, glyph->size[1] * scale};
+            batch_add(batch, font->tex, at, extent, 0.f, glyph->uv);
+        }
+        x += glyph->advance * scale;
+    }
+    return x;
+}
@@ -11,6 +11,15 @@
 #include <stdarg.h>
 #include <unistd.h>
 #include <ctype.h>
+#include <errno.h>
+#include <sys/stat.h>
+#if IBM
+#include <direct.h>
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#endif
 
 static void         (*log_fn)(const char *) = NULL;
 static const char   *log_prefix = "";
@@ -115,6 +124,98 @@ void fs_fix_path_inplace(char *path) {
     }
 }
 
+bool fs_mkdir(const char *path) {
+    ASSERT(path != NULL);
+#if IBM
+    if(_mkdir(path) == 0)
+        return true;
+#else
+    if(mkdir(path, 0755) == 0)
+        return true;
+#endif
+    return errno == EEXIST;
+}
+
+#if IBM
+const void *fs_map(const char *path, size_t *size) {
+    ASSERT(path != NULL);
+    ASSERT(size != NULL);
+    HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING,
+                              FILE_ATTRIBUTE_NORMAL, NULL);
+    if(file == INVALID_HANDLE_VALUE)
+        return NULL;
+    
+    const void *data = NULL;
+    LARGE_INTEGER file_size;
+    if(GetFileSizeEx(file, &file_size) && file_size.QuadPart > 0) {
+        // The view keeps the file mapped once the handles are closed.
+        HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+        if(mapping != NULL) {
+            data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+            CloseHandle(mapping);
+        }
+        *size = file_size.QuadPart;
+    }
+    CloseHandle(file);
+    return data;
+}
+
+void fs_unmap(const void *data, size_t size) {
+    UNUSED(size);
+    if(data != NULL)
+        UnmapViewOfFile(data);
+}
+#else
+const void *fs_map(const char *path, size_t *size) {
+    ASSERT(path != NULL);
+    ASSERT(size != NULL);
+    int fd = open(path, O_RDONLY);
+    if(fd < 0)
+        return NULL;
+    
+    void *data = NULL;
+    struct stat st;
+    if(fstat(fd, &st) == 0 && st.st_size > 0) {
+        data = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if(data == MAP_FAILED)
+            data = NULL;
+        *size = st.st_size;
+    }
+    close(fd);
+    return data;
+}
+
+void fs_unmap(const void *data, size_t size) {
+    if(data != NULL)
+        munmap((void *)data, size);
+}
+#endif
+
+char *fs_read(const char *path, size_t *size) {
+    ASSERT(path != NULL);
+    FILE *f = fopen(path, "rb");
+    if(!f)
+        return NULL;
+
+    char *data = NULL;
+    if(fseek(f, 0, SEEK_END) == 0) {
+        long len = ftell(f);
+        if(len >= 0 && fseek(f, 0, SEEK_SET) == 0) {
+            data = safe_malloc(len + 1);
+            if(fread(data, 1, len, f) == (size_t)len) {
+                data[len] = '\0';
+                if(size)
+                    *size = len;
+            } else {
+                free(data);
+                data = NULL;
+            }
+        }
+    }
+    fclose(f);
+    return data;
+}
+
 void str_trim_space(char *str) {
     ASSERT(str);
     
@@ -102,6 +102,15 @@ void assert_impl(bool val, const char *file, unsigned line, const char *expr);
 
 char *fs_make_path(const char *path, ...);
 void fs_fix_path_inplace(char *path);
+// Creates the directory at `path` (but not its parents). Returns true if it exists afterwards.
+bool fs_mkdir(const char *path);
+// Maps the file at `path` in memory, read-only. Returns NULL if it can't be opened.
+const void *fs_map(const char *path, size_t *size);
+void fs_unmap(const void *data, size_t size);
+// Reads the whole file at `path` into a NUL-terminated buffer the caller must free, and stores its
+// size in `size` if it isn't NULL. Returns NULL if it can't be read. Doesn't log, so it is safe to
+// call from any thread.
+char *fs_read(const char *path, size_t *size);
 
 // String handling
 
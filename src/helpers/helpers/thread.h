@@ -0,0 +1,38 @@
+/*===--------------------------------------------------------------------------------------------===
+ * thread.h
+ *
+ * Created by Amy Parent <amy@amyparent.com>
+ * Copyright (c) 2024 Laminar Research. All rights reserved
+ *
+ * Licensed under the MIT License
+ *===--------------------------------------------------------------------------------------------===
+*/
+#ifndef _UTILS_THREAD_
+#define _UTILS_THREAD_
+
+#include <stdbool.h>
+
+// Thin wrappers over pthreads and Win32 threads. X-Plane's APIs (including logging through
+// log_msg) must only be called from the sim thread, so anything running on a thread created here
+// has to stick to plain C.
+
+#if IBM
+#include <windows.h>
+typedef HANDLE              thread_t;
+typedef CRITICAL_SECTION    mutex_t;
+#else
+#include <pthread.h>
+typedef pthread_t           thread_t;
+typedef pthread_mutex_t     mutex_t;
+#endif
+
+bool thread_create(thread_t *thread, void (*proc)(void *), void *arg);
+void thread_join(thread_t *thread);
+void thread_sleep(unsigned ms);
+
+void mutex_init(mutex_t *mutex);
+void mutex_destroy(mutex_t *mutex);
+void mutex_enter(mutex_t *mutex);
+void mutex_exit(mutex_t *mutex);
+
+#endif /* ifndef _UTILS_THREAD_ */
@@ -0,0 +1,118 @@
+/*===--------------------------------------------------------------------------------------------===
+ * thread.c
+ *
+ * Created by Amy Parent <amy@amyparent.com>
+ * Copyright (c) 2024 Laminar Research. All rights reserved
+ *
+ * Licensed under the MIT License
+ *===--------------------------------------------------------------------------------------------===
+*/
+#include <helpers/thread.h>
+#include <helpers/helpers.h>
+#include <time.h>
+
+// The native thread entry points don't have the same signature, so threads start in a trampoline
+// that owns a copy of the procedure and its argument.
+typedef struct {
+    void    (*proc)(void *);
+    void    *arg;
+} thread_start_t;
+
+#if IBM
+
+static DWORD WINAPI thread_trampoline(LPVOID ptr) {
+    thread_start_t start = *(thread_start_t *)ptr;
+    free(ptr);
+    start.proc(start.arg);
+    return 0;
+}
+
+bool thread_create(thread_t *thread, void (*proc)(void *), void *arg) {
+    ASSERT(thread);
+    ASSERT(proc);
+    thread_start_t *start = safe_calloc(1, sizeof(*start));
+    start->proc = proc;
+    start->arg = arg;
+    *thread = CreateThread(NULL, 0, thread_trampoline, start, 0, NULL);
+    if(*thread == NULL) {
+        free(start);
+        return false;
+    }
+    return true;
+}
+
+void thread_join(thread_t *thread) {
+    ASSERT(thread);
+    WaitForSingleObject(*thread, INFINITE);
+    CloseHandle(*thread);
+}
+
+void thread_sleep(unsigned ms) {
+    Sleep(ms);
+}
+
+void mutex_init(mutex_t *mutex) {
+    InitializeCriticalSection(mutex);
+}
+
+void mutex_destroy(mutex_t *mutex) {
+    DeleteCriticalSection(mutex);
+}
+
+void mutex_enter(mutex_t *mutex) {
+    EnterCriticalSection(mutex);
+}
+
+void mutex_exit(mutex_t *mutex) {
+    LeaveCriticalSection(mutex);
+}
+
+#else
+
+static void *thread_trampoline(void *ptr) {
+    thread_start_t start = *(thread_start_t *)ptr;
+    free(ptr);
+    start.proc(start.arg);
+    return NULL;
+}
+
+bool thread_create(thread_t *thread, void (*proc)(void *), void *arg) {
+    ASSERT(thread);
+    ASSERT(proc);
+    thread_start_t *start = safe_calloc(1, sizeof(*start));
+    start->proc = proc;
+    start->arg = arg;
+    if(pthread_create(thread, NULL, thread_trampoline, start) != 0) {
+        free(start);
+        return false;
+    }
+    return true;
+}
+
+void thread_join(thread_t *thread) {
+    ASSERT(thread);
+    pthread_join(*thread, NULL);
+}
+
+void thread_sleep(unsigned ms) {
+    struct timespec ts = {.tv_sec = ms / 1000, .tv_nsec = (ms % 1000) * 1000000L};
+    nanosleep(&ts, NULL);
+}
+
+void mutex_init(mutex_t *mutex) {
+    pthread_mutex_init(mutex, NULL);
+}
+
+void mutex_destroy(mutex_t *mutex) {
+    pthread_mutex_destroy(mutex);
+}
+
+void mutex_enter(mutex_t *mutex) {
+    pthread_mutex_lock(mutex);
+}
+
+void mutex_exit(mutex_t *mutex) {
+    pthread_mutex_unlock(mutex);
+}
+
+#endif
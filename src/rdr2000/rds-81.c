@@ -12,13 +12,43 @@
 
 #include <XPLMGraphics.h>
 #include <XPLMMenus.h>
+#include <XPLMProcessing.h>
 #include <cglm/mat4.h>
-#define NANOVG_GL2_IMPLEMENTATION
-#include <nanovg_gl.h>
 #include <time.h>
 
 rds81_t *wxr = NULL;
 
+#define RDS_PARAM(t, n) {#n, t, offsetof(rds_params_t, n)}
+
+static const gl_block_desc_t rds_params_desc = {
+    .name = "params",
+    .binding = 0,
+    .size = sizeof(rds_params_t),
+    .count = 9,
+    .members = {
+        RDS_PARAM(GL_BLOCK_VEC2, aspect),
+        RDS_PARAM(GL_BLOCK_FLOAT, polar_lim),
+        RDS_PARAM(GL_BLOCK_FLOAT, polar_dist),
+        RDS_PARAM(GL_BLOCK_FLOAT, buf_h),
+        RDS_PARAM(GL_BLOCK_FLOAT, range),
+        RDS_PARAM(GL_BLOCK_FLOAT, gain),
+        RDS_PARAM(GL_BLOCK_FLOAT, ant_offset),
+        RDS_PARAM(GL_BLOCK_FLOAT, blink),
+        RDS_PARAM(GL_BLOCK_FLOAT, scale),
+    },
+};
+
+static const char *rds_uniform_names[RDS_U_COUNT] = {
+    [RDS_U_STRIDE] = "stride",
+    [RDS_U_COL_START] = "col_start",
+    [RDS_U_COL_END] = "col_end",
+    [RDS_U_ATTEN] = "atten",
+    [RDS_U_MASK] = "mask",
+    [RDS_U_MASK_RECT] = "mask_rect",
+};
+
+static void rds81_poll_resources(rds81_t *wxr);
+
 static void rds_get_xp_pvm(rds81_t *wxr, mat4 pvm) {
     mat4 proj_mat, mv_mat;
     ASSERT(XPLMGetDatavf(wxr->dr_proj_mat, (float *)proj_mat, 0, 16) == 16);
@@ -52,12 +82,11 @@ static float remap(float x, float a1, float b1, float a2, float b2) {
     return a2 + (x - a1) * (b2 - a2) / (b1 - a1);
 }
 
-static void rds_draw_knobs(rds81_t *wxr, mat4 pvm) {
+static void rds_draw_knobs(rds81_t *wxr) {
     for(int i = 0; i < KNOB_COUNT; ++i) {
         knob_t *knob = &wxr->knobs[i];
 
-        float val = knob->desc->type == KNOB_INT ?
-            XPLMGetDatai(knob->val) : XPLMGetDataf(knob->val);
+        float val = wxr->inputs.knobs[i];
         float angle = remap(val,
             knob->desc->min, knob->desc->max,
             knob->desc->min_angle, knob->desc->max_angle);
@@ -65,19 +94,38 @@ static void rds_draw_knobs(rds81_t *wxr, mat4 pvm) {
         
         vec2 pos = {knob->desc->pos[0], knob->desc->pos[1]};
         vec2 size = {knob->desc->size[0] * RDS_SCALE, knob->desc->size[1] * RDS_SCALE};
-        quad_render(pvm, knob->quad, pos, size, -angle, 1.f);
+        vec4 uv;
+        atlas_get_uv(wxr->atlas, knob->img, uv);
+        batch_add(wxr->bezel_batch, atlas_tex(wxr->atlas), pos, size, -angle, uv);
     }
 }
 
 static void rds_draw_bezel(float r, float g, float b, void *refcon) {
     rds81_t *wxr = refcon;
     ASSERT(wxr != NULL);
+    RDS_PERF_BEGIN(RDS_PERF_BEZEL);
+    rds81_read_inputs(wxr);
+    
     XPLMSetGraphicsState(0, 1, 0, 1, 1, 0, 0);
+    gl_state_invalidate();
+    rds81_poll_resources(wxr);
+    if(!wxr->ready) {
+        gl_state_reset();
+        RDS_PERF_END(RDS_PERF_BEZEL);
+        return;
+    }
+    
     mat4 pvm;
     rds_get_xp_pvm(wxr, pvm);
     // glCullFace(GL_BACK);
-    quad_render(pvm, wxr->bezel_quad, VEC2(0, 0), VEC2(RDS_BEZEL_W * RDS_SCALE, RDS_BEZEL_H * RDS_SCALE), 0.f, 1.f);
-    rds_draw_knobs(wxr, pvm);
+    batch_begin(wxr->bezel_batch, pvm);
+    vec4 uv;
+    atlas_get_uv(wxr->atlas, wxr->bezel_img, uv);
+    batch_add(wxr->bezel_batch, atlas_tex(wxr->atlas), VEC2(0, 0), VEC2(RDS_BEZEL_W * RDS_SCALE, RDS_BEZEL_H * RDS_SCALE), 0.f, uv);
+    rds_draw_knobs(wxr);
+    batch_end(wxr->bezel_batch);
+    gl_state_reset();
+    RDS_PERF_END(RDS_PERF_BEZEL);
 }
 
 #define WXR_CTR_X   (160*2.f)
@@ -89,28 +137,42 @@ static void rds_draw_bezel(float r, float g, float b, void *refcon) {
 #define WXR_POS_X   (WXR_CTR_X - (WXR_W/2))
 #define WXR_POS_Y   (WXR_CTR_Y)
 
-static void draw_fbo(rds81_t *wxr, NVGcontext *vg, mat4 pvm) {
-    float full_range = XPLMGetDataf(wxr->dr_range);
-    int stab = XPLMGetDatai(wxr->dr_stab);
-    
+// Copies the cartesian weather buffer onto the screen.
+void rds81_pass_copy(mat4 pvm) {
+    gl_push_group("wxr_copy");
+    gl_program_use(&wxr->shader_wxr);
+    quad_set_shader(wxr->wxr_quad, wxr->shader_wxr.id);
+    quad_render(pvm, wxr->wxr_quad, VEC2(WXR_POS_X, WXR_POS_Y), VEC2(WXR_W, WXR_H), 0.f, 1.f);
+    gl_pop_group();
+}
+
+static void draw_fbo(rds81_t *wxr, mat4 pvm) {
     glClearColor(0, 0, 0, 0);
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
     
     if(wxr->mode > RDS81_MODE_STBY) {
-        glUseProgram(wxr->shader_wxr);
-        // glUniform1f(glGetUniformLocation(wxr->shader_wxr, "blink"), blink);
-        quad_set_shader(wxr->wxr_quad, wxr->shader_wxr);
-        quad_render(pvm, wxr->wxr_quad, VEC2(WXR_POS_X, WXR_POS_Y), VEC2(WXR_W, WXR_H), 0.f, 1.f);
+        rds81_pass_copy(pvm);
         quad_render(pvm, wxr->dots_quad, VEC2(0, 0), VEC2(RDS_SCREEN_W, RDS_SCREEN_H), 0.f, 1.f);
     }
     
-    nvgFontSize(vg, 30.f);
-    nvgFontFace(vg, "default");
-    nvgTextAlign(vg, NVG_ALIGN_LEFT | NVG_ALIGN_BASELINE);
+    // The overlay's text is premultiplied, see rds81_update_overlay().
+    glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+    quad_render(pvm, wxr->overlay_quad, VEC2(0, 0), VEC2(RDS_SCREEN_W, RDS_SCREEN_H), 0.f, 1.f);
+}
+
+static const vec4 text_cyan = {0, 1, 1, 1};
+static const vec4 text_yellow = {1, 1, 0, 1};
+
+static void draw_text(rds81_t *wxr, float x, float y, const char *str) {
+    font_draw(wxr->font, wxr->text_batch, VEC2(x, y), RDS_FONT_SIZE, str);
+}
+
+static void draw_overlay(rds81_t *wxr, const rds_overlay_key_t *key) {
+    gl_batch_t *batch = wxr->text_batch;
     
     // Draw Range Info
-    if(wxr->mode > RDS81_MODE_STBY) {
-        nvgFillColor(vg, nvgRGB(0, 255, 255));
+    if(key->mode > RDS81_MODE_STBY) {
+        batch_set_color(batch, text_cyan);
     
         static const vec2 rng_pos[4] = {
             {RDS_SCREEN_W/2.f + 40, WXR_H-20},
@@ -121,85 +183,256 @@ static void draw_fbo(rds81_t *wxr, NVGcontext *vg, mat4 pvm) {
     
         for(int i = 0; i < 4; ++i) {
             char buf[32];
-            snprintf(buf, sizeof(buf), "%02.0f", full_range * (float)(i+1) / 4.f);
-            nvgText(vg, rng_pos[i][0] + 60, rng_pos[i][1], buf, NULL);
+            snprintf(buf, sizeof(buf), "%02.0f", key->range * (float)(i+1) / 4.f);
+            draw_text(wxr, rng_pos[i][0] + 60, rng_pos[i][1], buf);
         }
     
         // Draw Tilt info
-        nvgFontSize(vg, 30.f);
-        nvgFillColor(vg, nvgRGB(255, 255, 0));
-        float tilt = XPLMGetDataf(wxr->dr_tilt);
+        batch_set_color(batch, text_yellow);
+        float tilt = key->tilt;
         char buf[32];
         if(round(tilt * 10) == 0) {
-            nvgText(vg, RDS_SCREEN_W/2.f + 240, WXR_H-350, "0°", NULL);
+            draw_text(wxr, RDS_SCREEN_W/2.f + 240, WXR_H-350, "0°");
         } else {
             snprintf(buf, sizeof(buf), "%c %4.1f°", tilt > 0 ? 'U' : 'D', fabs(tilt));
-            nvgText(vg, RDS_SCREEN_W/2.f + 195, WXR_H-350, buf, NULL);
+            draw_text(wxr, RDS_SCREEN_W/2.f + 195, WXR_H-350, buf);
         }
     }
     
     // Draw Weather Mode
-    if(wxr->mode != RDS81_MODE_OFF) {
+    if(key->mode != RDS81_MODE_OFF) {
         const char *mode_str = "STBY";
-        switch(wxr->mode) {
+        switch(key->mode) {
         case RDS81_MODE_OFF:
         case RDS81_MODE_STBY: mode_str = "STBY"; break;
         case RDS81_MODE_TEST: mode_str = "TEST"; break;
         case RDS81_MODE_ON:
-            if(wxr->submode == RDS81_SUBMODE_WX)
+            if(key->submode == RDS81_SUBMODE_WX)
                 mode_str = "WX";
-            else if(wxr->submode == RDS81_SUBMODE_WXA)
+            else if(key->submode == RDS81_SUBMODE_WXA)
                 mode_str = "WXA";
-            else if(wxr->submode == RDS81_SUBMODE_MAP)
+            else if(key->submode == RDS81_SUBMODE_MAP)
                 mode_str = "MAP";
             break;
         }
-        nvgFillColor(vg, nvgRGB(0, 255, 255));
-        nvgText(vg, WXR_POS_X+20, WXR_H-40, mode_str, NULL);
+        batch_set_color(batch, text_cyan);
+        draw_text(wxr, WXR_POS_X+20, WXR_H-40, mode_str);
     }
     
     // Draw Stab Info
-    if(wxr->mode > RDS81_MODE_STBY && stab != 1) {
-        nvgFillColor(vg, nvgRGB(0, 255, 255));
-        nvgText(vg, WXR_POS_X+20, WXR_H-340, "STAB OFF", NULL);
+    if(key->mode > RDS81_MODE_STBY && key->stab != 1) {
+        batch_set_color(batch, text_cyan);
+        draw_text(wxr, WXR_POS_X+20, WXR_H-340, "STAB OFF");
+    }
+}
+
+static bool rds_overlay_key_eq(const rds_overlay_key_t *a, const rds_overlay_key_t *b) {
+    return a->mode == b->mode
+        && a->submode == b->submode
+        && a->stab == b->stab
+        && a->range == b->range
+        && a->tilt == b->tilt;
+}
+
+// The text on the screen only changes with the range, tilt, mode and stabilisation, so it is drawn
+// in its own buffer when one of those changes, and only composited every frame.
+void rds81_update_overlay(rds81_t *wxr) {
+    rds_overlay_key_t key = {
+        .mode = wxr->mode,
+        .submode = wxr->submode,
+        .stab = wxr->inputs.stab,
+        .range = wxr->inputs.range,
+        .tilt = wxr->inputs.tilt,
+    };
+    if(wxr->overlay_valid && rds_overlay_key_eq(&key, &wxr->overlay_key))
+        return;
+    wxr->overlay_key = key;
+    wxr->overlay_valid = true;
+    
+    gl_push_group("overlay");
+    glBindFramebuffer(GL_FRAMEBUFFER, wxr->overlay_fbo);
+    glViewport(0, 0, RDS_SCREEN_W/2, RDS_SCREEN_H/2);
+    glClearColor(0, 0, 0, 0);
+    glClear(GL_COLOR_BUFFER_BIT);
+    if(!wxr->font) {
+        gl_pop_group();
+        return;
     }
+    
+    // The text is laid out with Y going down, from the top of the screen. The glyphs are baked
+    // with premultiplied alpha, so the overlay ends up premultiplied too.
+    mat4 ortho;
+    glm_ortho(0, RDS_SCREEN_W, RDS_SCREEN_H, 0, -1, 1, ortho);
+    batch_begin(wxr->text_batch, ortho);
+    draw_overlay(wxr, &key);
+    glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+    batch_end(wxr->text_batch);
+    gl_pop_group();
+}
+
+// Returns the (fractional) polar buffer column an antenna angle, in degrees, falls on.
+static float rds_polar_col(float angle) {
+    return RDS_WXR_POLAR_W * (angle + RDS_WXR_POLAR_LIM) / (2.f * RDS_WXR_POLAR_LIM);
 }
 
-static void rds_update_wxr_tex(int src_tex, int shader) {
+// Finds the range of polar columns [x0, x1) between `start` and `end`, widened by `margin` degrees.
+static void rds_polar_cols(float start, float end, float margin, int *x0, int *x1) {
+    *x0 = MAX((int)floorf(rds_polar_col(start - margin)), 0);
+    *x1 = MIN((int)ceilf(rds_polar_col(end + margin)), RDS_WXR_POLAR_W);
+    *x1 = MAX(*x1, *x0 + 1);
+}
+
+// Restricts drawing to the polar columns between `start` and `end`, widened by `margin` degrees.
+static void rds_polar_scissor(float start, float end, float margin) {
+    int x0, x1;
+    rds_polar_cols(start, end, margin, &x0, &x1);
+    glScissor(x0, 0, x1 - x0, RDS_WXR_POLAR_H);
+}
+
+// Computes the cumulative attenuation along the swept columns of the polar returns buffer, once per
+// column instead of once per antenna fragment. With compute shaders, each invocation scans one
+// column. Otherwise, we ping-pong a log2(RDS_WXR_POLAR_H) pass scan between two buffers. Returns
+// the texture the result ended up in.
+GLuint rds81_update_atten(float start, float end, mat4 ortho) {
+    gl_push_group("wxr_atten");
+    if(wxr->shader_atten_cs.id) {
+        int x0, x1;
+        rds_polar_cols(start, end, 0.f, &x0, &x1);
+        
+        gl_program_use(&wxr->shader_atten_cs);
+        glUniform1i(wxr->shader_atten_cs.loc[RDS_U_COL_START], x0);
+        glUniform1i(wxr->shader_atten_cs.loc[RDS_U_COL_END], x1);
+        
+        XPLMBindTexture2d(wxr->polar_src_tex, 0);
+        glBindImageTexture(0, wxr->atten_tex[0], 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_R32F);
+        glDispatchCompute((x1 - x0 + 63) / 64, 1, 1);
+        glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT);
+        glBindImageTexture(0, 0, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_R32F);
+        gl_pop_group();
+        return wxr->atten_tex[0];
+    }
+    
+    rds_polar_scissor(start, end, 0.f);
+    quad_set_shader(wxr->atten_quad, wxr->shader_atten.id);
+    
+    int dst = 0;
+    GLuint src_tex = wxr->polar_src_tex;
+    for(int stride = 0; stride < RDS_WXR_POLAR_H; stride = MAX(stride * 2, 1)) {
+        glBindFramebuffer(GL_FRAMEBUFFER, wxr->atten_fbo[dst]);
+        gl_program_use(&wxr->shader_atten);
+        glUniform1f(wxr->shader_atten.loc[RDS_U_STRIDE], stride);
+        
+        quad_set_tex(wxr->atten_quad, src_tex);
+        quad_render(ortho, wxr->atten_quad, VEC2(0, 0), VEC2(RDS_WXR_POLAR_W, RDS_WXR_POLAR_H), 0.f, 1.f);
+        
+        src_tex = wxr->atten_tex[dst];
+        dst = 1 - dst;
+    }
+    gl_pop_group();
+    return src_tex;
+}
+
+// Resamples X-Plane's radar texture into the polar returns buffer, over the azimuths between
+// `start` and `end` and enough on either side for the smearing.
+void rds81_pass_polar(GLuint src_tex, float start, float end, mat4 ortho) {
+    gl_push_group("wxr_polar");
+    glBindFramebuffer(GL_FRAMEBUFFER, wxr->polar_src_fbo);
+    rds_polar_scissor(start, end, RDS_WXR_SMEAR_LIM);
+    
+    gl_program_use(&wxr->shader_polar);
     quad_set_tex(wxr->src_quad, src_tex);
+    quad_set_shader(wxr->src_quad, wxr->shader_polar.id);
+    quad_render(ortho, wxr->src_quad, VEC2(0, 0), VEC2(RDS_WXR_POLAR_W, RDS_WXR_POLAR_H), 0.f, 1.f);
+    gl_pop_group();
+}
+
+// Runs the antenna (or test) program over the polar buffer between `start` and `end`.
+void rds81_pass_sweep(gl_program_t *shader, GLuint atten_tex, float start, float end, mat4 ortho) {
+    gl_push_group("wxr_sweep");
+    glBindFramebuffer(GL_FRAMEBUFFER, wxr->polar_fbo);
+    rds_polar_scissor(start, end, 0.f);
+    
+    gl_program_use(shader);
+    XPLMBindTexture2d(atten_tex, 1);
+    quad_set_shader(wxr->polar_quad, shader->id);
+    quad_render(ortho, wxr->polar_quad, VEC2(0, 0), VEC2(RDS_WXR_POLAR_W, RDS_WXR_POLAR_H), 0.f, 1.f);
+    XPLMBindTexture2d(0, 1);
+    gl_pop_group();
+}
+
+// Scan-converts the polar picture between `start` and `end` into the cartesian buffer. Only that
+// wedge is rasterised. Its radius reaches the far corners of the buffer, and the sector's rim is
+// the same from one frame to the next so that consecutive wedges neither overlap nor leave gaps.
+void rds81_pass_scan(float start, float end) {
+    mat4 ortho;
+    glm_ortho(0, RDS_WXR_BUF_W, 0, RDS_WXR_BUF_H, -1, 1, ortho);
+    gl_push_group("wxr_scan");
     glBindFramebuffer(GL_FRAMEBUFFER, wxr->wxr_fbo);
     glViewport(0, 0, RDS_WXR_BUF_W, RDS_WXR_BUF_H);
     
+    gl_program_use(&wxr->shader_scan);
+    sector_set_shader(wxr->scan_sector, wxr->shader_scan.id);
+    sector_render(ortho, wxr->scan_sector, VEC2(RDS_WXR_BUF_W, RDS_WXR_BUF_H),
+                  VEC2(RDS_WXR_BUF_W/2.f, 0), RDS_WXR_POLAR_DIST * RDS_WXR_BUF_H,
+                  DEG2RAD(start), DEG2RAD(end), 1.f);
+    gl_pop_group();
+}
+
+// The weather picture is built in three passes:
+//
+//  1. X-Plane's radar texture is resampled into the polar returns buffer;
+//  2. the antenna (or test) pass simulates attenuation, smearing and noise in the polar domain;
+//  3. the polar picture is scan-converted into the cartesian buffer the screen samples from.
+//
+// The passes only run when the antenna has stepped (see rds81_update()), and the first two are
+// scissored to the azimuth bins swept since the last time, so their cost scales with the sweep
+// rather than the frame rate, and the path-integrated attenuation only has to walk down one column.
+static void rds_update_wxr_tex(int src_tex, bool test) {
     if(wxr->ant_clear || !wxr->is_warm) {
         glClearColor(0, 0, 0, 1);
+        glBindFramebuffer(GL_FRAMEBUFFER, wxr->polar_src_fbo);
+        glClear(GL_COLOR_BUFFER_BIT);
+        glBindFramebuffer(GL_FRAMEBUFFER, wxr->polar_fbo);
+        glClear(GL_COLOR_BUFFER_BIT);
+        glBindFramebuffer(GL_FRAMEBUFFER, wxr->wxr_fbo);
         glClear(GL_COLOR_BUFFER_BIT);
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
         wxr->ant_clear = false;
+        wxr->sweep_pending = false;
         return;
     }
     
-
-    mat4 ortho;
-    glm_ortho(0, RDS_WXR_BUF_W, 0, RDS_WXR_BUF_H, -1, 1, ortho);
+    // The antenna only moves in steps, so most frames have nothing new to sweep.
+    if(!wxr->sweep_pending)
+        return;
+    wxr->sweep_pending = false;
+    float start = wxr->sweep_start;
+    float end = wxr->sweep_end;
     
-    // Get the data we need
-    float full_range = XPLMGetDataf(wxr->dr_range);
-    
-    glUseProgram(shader);
-    glUniform2f(glGetUniformLocation(shader, "aspect"), (float)RDS_WXR_BUF_W/(float)RDS_WXR_BUF_H, 1.f);
-    glUniform1f(glGetUniformLocation(shader, "ant_lim"), DEG2RAD(RDS_ANT_LIM));
-    glUniform1f(glGetUniformLocation(shader, "range"), full_range);
-    glUniform1f(glGetUniformLocation(shader, "gain"), wxr->eff_gain);
-    glUniform1f(glGetUniformLocation(shader, "ant_offset"), -(float)wxr->ant_dir);
-    if(wxr->ant_angle > wxr->ant_angle_last) {
-        glUniform1f(glGetUniformLocation(shader, "angle_start"), DEG2RAD(wxr->ant_angle_last));
-        glUniform1f(glGetUniformLocation(shader, "angle_end"), DEG2RAD(wxr->ant_angle));
-    } else {
-        glUniform1f(glGetUniformLocation(shader, "angle_start"), DEG2RAD(wxr->ant_angle));
-        glUniform1f(glGetUniformLocation(shader, "angle_end"), DEG2RAD(wxr->ant_angle_last));
+    mat4 ortho;
+    glm_ortho(0, RDS_WXR_POLAR_W, 0, RDS_WXR_POLAR_H, -1, 1, ortho);
+    
+    glViewport(0, 0, RDS_WXR_POLAR_W, RDS_WXR_POLAR_H);
+    glEnable(GL_SCISSOR_TEST);
+    
+    // The test pattern doesn't look at returns, so we don't bother resampling them.
+    GLuint atten_tex = 0;
+    if(!test) {
+        RDS_TRACE_BEGIN("wxr_polar");
+        rds81_pass_polar(src_tex, start, end, ortho);
+        RDS_TRACE_END("wxr_polar");
+        RDS_TRACE_BEGIN("wxr_atten");
+        atten_tex = rds81_update_atten(start, end, ortho);
+        RDS_TRACE_END("wxr_atten");
     }
-
-    quad_set_shader(wxr->src_quad, shader);
-    quad_render(ortho, wxr->src_quad, VEC2(0, 0), VEC2(RDS_WXR_BUF_W, RDS_WXR_BUF_H), 0.f, 1.f);
+    RDS_TRACE_BEGIN("wxr_sweep");
+    rds81_pass_sweep(test ? &wxr->shader_test : &wxr->shader_ant, atten_tex, start, end, ortho);
+    RDS_TRACE_END("wxr_sweep");
+    glDisable(GL_SCISSOR_TEST);
+    
+    RDS_TRACE_BEGIN("wxr_scan");
+    rds81_pass_scan(start, end);
+    RDS_TRACE_END("wxr_scan");
     glBindFramebuffer(GL_FRAMEBUFFER, 0);
 }
 
@@ -209,11 +442,62 @@ static float ease_out_cubic(float t)
 	return f * f * f + 1;
 }
 
+// Gathers everything the radar shaders need for this frame, so the uniform block is only updated
+// once (and only if anything changed).
+void rds81_update_params(rds81_t *wxr) {
+    // For the "turning on" animation, we compute the time since we turned on, then use that
+    // to simulate "warmup" (AKA the alpha slowly ramps up, and the dispaly "zooms in".)
+    double time_since_on = time_get_clock() - wxr->on_time;
+    float t = CLAMP(time_since_on / RDS_WARMUP_SCALE, 0.f, 1.f);
+    
+    rds_params_t params = {
+        .aspect = {(float)RDS_WXR_BUF_W/(float)RDS_WXR_BUF_H, 1.f},
+        .polar_lim = DEG2RAD(RDS_WXR_POLAR_LIM),
+        .polar_dist = RDS_WXR_POLAR_DIST,
+        .buf_h = RDS_WXR_POLAR_H,
+        .range = wxr->inputs.range,
+        .gain = wxr->eff_gain,
+        .ant_offset = -(float)wxr->ant_dir,
+        .blink = 1.f,
+        .scale = 0.1f + 0.9f * ease_out_cubic(t),
+    };
+    if(wxr->submode == RDS81_SUBMODE_WXA) {
+        params.blink = (int)(time_since_on * 2.f) % 2;
+    }
+    gl_block_update(wxr->params, &params);
+}
+
+// Draws the finished screen, through the CRT mask, into X-Plane's avionics buffer.
+void rds81_pass_screen(mat4 pvm) {
+    gl_push_group("screen");
+    gl_program_use(&wxr->shader_screen);
+    
+    XPLMBindTexture2d(wxr->screen_tex, 0);
+    XPLMBindTexture2d(atlas_tex(wxr->atlas), 1);
+    
+    quad_set_shader(wxr->screen_quad, wxr->shader_screen.id);
+    quad_render(pvm, wxr->screen_quad, VEC2(0, 0), VEC2(RDS_SCREEN_W * RDS_SCALE, RDS_SCREEN_H * RDS_SCALE), 0.f, 1.f);
+    XPLMBindTexture2d(0, 1);
+    gl_pop_group();
+}
+
 static void rds_draw_screen(void *refcon) {
     rds81_t *wxr = refcon;
     ASSERT(wxr != NULL);
+    RDS_PERF_BEGIN(RDS_PERF_SCREEN);
     
+    rds81_read_inputs(wxr);
+    RDS_PERF_BEGIN(RDS_PERF_UPDATE);
     rds81_update(wxr);
+    RDS_PERF_END(RDS_PERF_UPDATE);
+    
+    // Off or unpowered, the screen is blank, and there is nothing else to do.
+    if(wxr->idle) {
+        glClearColor(0, 0, 0, 1);
+        glClear(GL_COLOR_BUFFER_BIT);
+        RDS_PERF_END(RDS_PERF_SCREEN);
+        return;
+    }
     
     // Save XP data
     int old_vp[4];
@@ -221,55 +505,46 @@ static void rds_draw_screen(void *refcon) {
     XPLMGetDatavi(wxr->dr_viewport, old_vp, 0, 4);
 
     XPLMSetGraphicsState(0, 2, 0, 1, 1, 0, 0);
+    gl_state_invalidate();
+    rds81_poll_resources(wxr);
     glClearColor(0, 0, 0, 1);
     glClear(GL_COLOR_BUFFER_BIT);
     
-    int src_wxr = XPLMGetTexture(wxr->wxr_tex_id);
-    rds_update_wxr_tex(src_wxr, wxr->mode == RDS81_MODE_TEST ? wxr->shader_test : wxr->shader_ant);
+    rds81_update_params(wxr);
     
-    if(wxr->mode > RDS81_MODE_OFF && rds81_has_power(wxr)) {
+    if(wxr->mode > RDS81_MODE_OFF && rds81_has_power(wxr) && wxr->ready) {
+        if(!wxr->screen_alloc)
+            rds81_alloc_screen(wxr);
+        wxr->screen_used = time_get_clock();
+        
+        int src_wxr = XPLMGetTexture(wxr->wxr_tex_id);
+        RDS_PERF_BEGIN(RDS_PERF_WXR_TEX);
+        rds_update_wxr_tex(src_wxr, wxr->mode == RDS81_MODE_TEST);
+        RDS_PERF_END(RDS_PERF_WXR_TEX);
+        RDS_TRACE_BEGIN("overlay");
+        rds81_update_overlay(wxr);
+        RDS_TRACE_END("overlay");
+        
         mat4 ortho;
         glm_ortho(0, RDS_SCREEN_W, 0, RDS_SCREEN_H, -1, 1, ortho);
         glBindFramebuffer(GL_FRAMEBUFFER, wxr->screen_fbo);
         glViewport(0, 0, RDS_SCREEN_W/2, RDS_SCREEN_H/2);
-    
-        nvgBeginFrame(wxr->vg, RDS_SCREEN_W, RDS_SCREEN_H, 2);
-        draw_fbo(wxr, wxr->vg, ortho);
-        nvgEndFrame(wxr->vg);
+        RDS_PERF_BEGIN(RDS_PERF_DRAW_FBO);
+        draw_fbo(wxr, ortho);
+        RDS_PERF_END(RDS_PERF_DRAW_FBO);
     
         // Revert to how things were before we mucked with OpenGL state
         glBindFramebuffer(GL_FRAMEBUFFER, old_fbo);
         glViewport(old_vp[0], old_vp[1], old_vp[2], old_vp[3]);
-    
-    
-        // For the "turning on" animation, we compute the time since we turned on, then use that
-        // to simulate "warmup" (AKA the alpha slowly ramps up, and the dispaly "zooms in".)
-        double time_since_on = time_get_clock() - wxr->on_time;
-        float t = CLAMP(time_since_on / RDS_WARMUP_SCALE, 0.f, 1.f);
-        float scale = 0.1f + 0.9f * ease_out_cubic(t);
-        
-
-        float blink = 1.f;
-        if(wxr->submode == RDS81_SUBMODE_WXA) {
-            blink = (int)(time_since_on * 2.f) % 2;
-        }
         
         mat4 pvm;
         rds_get_xp_pvm(wxr, pvm);
-        glUseProgram(wxr->shader_screen);
-        
-        XPLMBindTexture2d(wxr->screen_tex, 0);
-        XPLMBindTexture2d(wxr->crt_mask_tex, 1);
-        glUniform1f(glGetUniformLocation(wxr->shader_screen, "blink"), blink);
-        glUniform1i(glGetUniformLocation(wxr->shader_screen, "mask"), 1);
-        glUniform1f(glGetUniformLocation(wxr->shader_screen, "scale"), scale);
-        
-        quad_set_shader(wxr->screen_quad, wxr->shader_screen);
-        quad_render(pvm, wxr->screen_quad, VEC2(0, 0), VEC2(RDS_SCREEN_W * RDS_SCALE, RDS_SCREEN_H * RDS_SCALE), 0.f, 1.f);
-        
-        XPLMBindTexture2d(0, 0);
-        XPLMBindTexture2d(0, 1);
+        RDS_TRACE_BEGIN("composite");
+        rds81_pass_screen(pvm);
+        RDS_TRACE_END("composite");
     }
+    gl_state_reset();
+    RDS_PERF_END(RDS_PERF_SCREEN);
 }
 
 static int rds_click_bezel(int x, int y, XPLMMouseStatus mouse, void *refcon) {
@@ -308,6 +583,7 @@ static float rds_brightness(float rheo, float ambiant, float bus, void *refcon)
     rds81_t *wxr = refcon;
     ASSERT(wxr != NULL);
     
+    rds81_read_inputs(wxr);
     double time_since_on = time_get_clock() - wxr->on_time;
     float alpha = 0.2f + 0.8f * CLAMP(powf(time_since_on / RDS_WARMUP_ALPHA, 2), 0.f, 1.f);
     
@@ -317,7 +593,14 @@ static float rds_brightness(float rheo, float ambiant, float bus, void *refcon)
 
 // MARK: - "public" API
 
-GLuint rds81_load_shader(const char *name) {
+static const char *rds81_read_shader(const char *fname, char **buffer) {
+    char name[64];
+    snprintf(name, sizeof(name), "shaders/%s", fname);
+    return resource_read(name, buffer);
+}
+
+// Starts linking the program `name` for `prog`, see rds81_end_shaders().
+static void rds81_begin_shader(rds_link_t *link, gl_program_t *prog, const char *name) {
     
     char fname_vert[64];
     char fname_frag[64];
@@ -330,45 +613,289 @@ GLuint rds81_load_shader(const char *name) {
         snprintf(fname_frag, sizeof(fname_frag), "%s.frag.120", name);
     }
     
-    char *vert_path = fs_make_path(get_plugin_dir(), "resources", "shaders", fname_vert, NULL);
-    char *frag_path = fs_make_path(get_plugin_dir(), "resources", "shaders", fname_frag, NULL);
+    char *vert_buf, *frag_buf;
+    const char *vert = rds81_read_shader(fname_vert, &vert_buf);
+    const char *frag = rds81_read_shader(fname_frag, &frag_buf);
     
-    GLuint shader = gl_program_new_file(vert_path, frag_path);
+    link->prog = prog;
+    memset(&link->link, 0, sizeof(link->link));
+    if(vert && frag)
+        gl_program_begin(&link->link, fname_vert, vert, frag);
     
-    free(vert_path);
-    free(frag_path);
+    free(vert_buf);
+    free(frag_buf);
+}
+
+// Compute shaders are only used with GL 4.3+; callers need a fallback for when the program is 0.
+static void rds81_begin_compute_shader(rds_link_t *link, gl_program_t *prog, const char *name) {
+    link->prog = prog;
+    if(!GLEW_VERSION_4_3) {
+        memset(&link->link, 0, sizeof(link->link));
+        return;
+    }
     
-    return shader;
+    char fname[64];
+    snprintf(fname, sizeof(fname), "%s.comp.430", name);
+    char *comp_buf;
+    const char *comp = rds81_read_shader(fname, &comp_buf);
+    memset(&link->link, 0, sizeof(link->link));
+    if(comp)
+        gl_compute_program_begin(&link->link, fname, comp);
+    free(comp_buf);
 }
 
 
-static void rds81_reload_shaders() {
-    if(wxr == NULL)
+// (Re-)links `prog` from `id`, caching the uniform locations we need.
+static void rds81_init_program(gl_program_t *prog, GLuint id) {
+    gl_program_fini(prog);
+    gl_program_init(prog, id, wxr->params, rds_uniform_names, RDS_U_COUNT);
+}
+
+// Sampler units never change, so they only need setting when programs are linked.
+static void rds81_set_sampler(gl_program_t *prog, rds_uniform_t sampler, int unit) {
+    gl_use_program(prog->id);
+    glUniform1i(prog->loc[sampler], unit);
+}
+
+// The CRT mask is one of the images in the atlas, so the screen shader needs to know where.
+static void rds81_set_mask_rect() {
+    vec4 mask_rect;
+    atlas_get_uv(wxr->atlas, wxr->crt_mask_img, mask_rect);
+    gl_use_program(wxr->shader_screen.id);
+    glUniform4fv(wxr->shader_screen.loc[RDS_U_MASK_RECT], 1, mask_rect);
+}
+
+// Linked programs are cached in X-Plane's output folder, so later loads can skip compiling them.
+static void rds81_init_progcache() {
+    char *caches_dir = fs_make_path(get_xplane_dir(), "Output", "caches", NULL);
+    char *cache_dir = fs_make_path(get_xplane_dir(), "Output", "caches", "rdr2000", NULL);
+    
+    if(fs_mkdir(caches_dir) && fs_mkdir(cache_dir))
+        gl_progcache_init(cache_dir);
+    else
+        log_msg("cannot create shader cache folder `%s`", cache_dir);
+    
+    free(caches_dir);
+    free(cache_dir);
+}
+
+// Submits every radar program to the driver. They're only used once rds81_end_shaders() has run,
+// which rds81_poll_resources() does when the driver is done with all of them.
+static void rds81_begin_shaders() {
+    rds_link_t *links = wxr->links;
+    for(int i = 0; i < RDS_PROGRAM_COUNT; ++i) {
+        // Shaders can be reloaded before the previous ones are done linking.
+        if(links[i].link.id)
+            glDeleteProgram(links[i].link.id);
+    }
+    
+    rds81_begin_shader(&links[0], &wxr->shader_wxr, "wxr_copy");
+    rds81_begin_shader(&links[1], &wxr->shader_screen, "rdr_screen");
+    rds81_begin_shader(&links[2], &wxr->shader_ant, "wxr_antenna");
+    rds81_begin_shader(&links[3], &wxr->shader_test, "wxr_test");
+    rds81_begin_shader(&links[4], &wxr->shader_polar, "wxr_polar");
+    rds81_begin_shader(&links[5], &wxr->shader_scan, "wxr_scan");
+    rds81_begin_shader(&links[6], &wxr->shader_atten, "wxr_atten_scan");
+    rds81_begin_compute_shader(&links[7], &wxr->shader_atten_cs, "wxr_atten");
+    wxr->shaders_ready = false;
+}
+
+static bool rds81_shaders_linked() {
+    for(int i = 0; i < RDS_PROGRAM_COUNT; ++i) {
+        if(!gl_program_ready(&wxr->links[i].link))
+            return false;
+    }
+    return true;
+}
+
+// Swaps in the programs started by rds81_begin_shaders(), waiting for the driver if needed.
+static void rds81_end_shaders() {
+    RDS_TRACE_BEGIN(__func__);
+    for(int i = 0; i < RDS_PROGRAM_COUNT; ++i)
+        rds81_init_program(wxr->links[i].prog, gl_program_end(&wxr->links[i].link));
+    
+    rds81_set_sampler(&wxr->shader_ant, RDS_U_ATTEN, 1);
+    rds81_set_sampler(&wxr->shader_screen, RDS_U_MASK, 1);
+    
+    wxr->shaders_ready = true;
+    RDS_TRACE_END(__func__);
+}
+
+// Names a buffer and its texture, for GL debuggers and the driver's messages.
+static void rds81_label_fbo(GLuint fbo, GLuint tex, const char *name) {
+    gl_label(GL_FRAMEBUFFER, fbo, name);
+    gl_label(GL_TEXTURE, tex, name);
+}
+
+// The screen's buffers, font and quads are only needed while the radar is on and powered, so they
+// are allocated the first time it draws that way, rather than at init. rds81_idle_floop() releases
+// them once they've gone unused for a while. The bezel, atlas and programs always stay resident.
+void rds81_alloc_screen(rds81_t *wxr) {
+    RDS_TRACE_BEGIN(__func__);
+    ASSERT(wxr->shaders_ready);
+    
+    wxr->wxr_fbo = gl_fbo_new(RDS_WXR_BUF_W, RDS_WXR_BUF_H, &wxr->wxr_tex);
+    wxr->polar_src_fbo = gl_fbo_new_fmt(RDS_WXR_POLAR_W, RDS_WXR_POLAR_H, GL_R16F, &wxr->polar_src_tex);
+    wxr->polar_fbo = gl_fbo_new(RDS_WXR_POLAR_W, RDS_WXR_POLAR_H, &wxr->polar_tex);
+    for(int i = 0; i < 2; ++i)
+        wxr->atten_fbo[i] = gl_fbo_new_fmt(RDS_WXR_POLAR_W, RDS_WXR_POLAR_H, GL_R32F, &wxr->atten_tex[i]);
+    wxr->screen_fbo = gl_fbo_new(RDS_SCREEN_W/2, RDS_SCREEN_H/2, &wxr->screen_tex);
+    wxr->overlay_fbo = gl_fbo_new(RDS_SCREEN_W/2, RDS_SCREEN_H/2, &wxr->overlay_tex);
+    rds81_label_fbo(wxr->wxr_fbo, wxr->wxr_tex, "rdr2000_wxr");
+    rds81_label_fbo(wxr->polar_src_fbo, wxr->polar_src_tex, "rdr2000_polar_src");
+    rds81_label_fbo(wxr->polar_fbo, wxr->polar_tex, "rdr2000_polar");
+    rds81_label_fbo(wxr->atten_fbo[0], wxr->atten_tex[0], "rdr2000_atten0");
+    rds81_label_fbo(wxr->atten_fbo[1], wxr->atten_tex[1], "rdr2000_atten1");
+    rds81_label_fbo(wxr->screen_fbo, wxr->screen_tex, "rdr2000_screen");
+    rds81_label_fbo(wxr->overlay_fbo, wxr->overlay_tex, "rdr2000_overlay");
+    
+    wxr->text_batch = batch_new(RDS_TEXT_SPRITES);
+    // The overlay's font is baked at build time, see texconv.
+    const resource_t *font = resource_find("font.rtex");
+    wxr->font = font ? font_load(font->data, font->size) : NULL;
+    
+    // The quads that draw with the radar programs get them when they're rendered, but they need
+    // a linked program to start with.
+    wxr->src_quad = quad_new(0, wxr->shader_polar.id);
+    wxr->polar_quad = quad_new(wxr->polar_src_tex, wxr->shader_ant.id);
+    wxr->atten_quad = quad_new(wxr->polar_src_tex, wxr->shader_atten.id);
+    wxr->scan_sector = sector_new(wxr->polar_tex, wxr->shader_scan.id);
+    wxr->screen_quad = quad_new(wxr->screen_tex, wxr->shader_screen.id);
+    wxr->wxr_quad = quad_new(wxr->wxr_tex, wxr->shader_wxr.id);
+    wxr->overlay_quad = quad_new(wxr->overlay_tex, 0);
+    
+    // The new buffers hold garbage until the sweep and overlay are redrawn into them.
+    wxr->ant_clear = true;
+    wxr->overlay_valid = false;
+    wxr->screen_alloc = true;
+    log_msg("allocated screen resources");
+    RDS_TRACE_END(__func__);
+}
+
+static void rds81_free_screen(rds81_t *wxr) {
+    if(!wxr->screen_alloc)
         return;
+    RDS_TRACE_BEGIN(__func__);
     
-    if(wxr->shader_wxr)
-        glDeleteProgram(wxr->shader_wxr);
-    if(wxr->shader_screen)
-        glDeleteProgram(wxr->shader_screen);
-    if(wxr->shader_ant)
-        glDeleteProgram(wxr->shader_ant);
-    if(wxr->shader_test)
-        glDeleteProgram(wxr->shader_test);
+    batch_destroy(wxr->text_batch);
+    if(wxr->font)
+        font_destroy(wxr->font);
+    quad_destroy(wxr->screen_quad);
+    quad_destroy(wxr->wxr_quad);
+    quad_destroy(wxr->overlay_quad);
+    quad_destroy(wxr->src_quad);
+    quad_destroy(wxr->polar_quad);
+    quad_destroy(wxr->atten_quad);
+    sector_destroy(wxr->scan_sector);
     
-    wxr->shader_wxr = rds81_load_shader("wxr_copy");
-    wxr->shader_screen = rds81_load_shader("rdr_screen");
-    wxr->shader_ant = rds81_load_shader("wxr_antenna");
-    wxr->shader_test = rds81_load_shader("wxr_test");
+    glDeleteTextures(1, &wxr->wxr_tex);
+    glDeleteTextures(1, &wxr->polar_src_tex);
+    glDeleteTextures(1, &wxr->polar_tex);
+    glDeleteTextures(2, wxr->atten_tex);
+    glDeleteTextures(1, &wxr->screen_tex);
+    glDeleteTextures(1, &wxr->overlay_tex);
+    glDeleteFramebuffers(1, &wxr->wxr_fbo);
+    glDeleteFramebuffers(1, &wxr->polar_src_fbo);
+    glDeleteFramebuffers(1, &wxr->polar_fbo);
+    glDeleteFramebuffers(2, wxr->atten_fbo);
+    glDeleteFramebuffers(1, &wxr->screen_fbo);
+    glDeleteFramebuffers(1, &wxr->overlay_fbo);
+    
+    wxr->text_batch = NULL;
+    wxr->font = NULL;
+    wxr->screen_quad = wxr->wxr_quad = wxr->overlay_quad = NULL;
+    wxr->src_quad = wxr->polar_quad = wxr->atten_quad = NULL;
+    wxr->scan_sector = NULL;
+    wxr->screen_alloc = false;
+    log_msg("released screen resources");
+    RDS_TRACE_END(__func__);
 }
 
-GLuint rds81_load_tex(const char *name) {
+// The screen callback only runs while the radar is in view, so the idle timeout is checked from
+// a flight loop instead. A negative timeout keeps the screen's resources for good.
+static float rds81_idle_floop(float elapsed, float since_last_fl, int counter, void *refcon) {
+    UNUSED(elapsed);
+    UNUSED(since_last_fl);
+    UNUSED(counter);
+    rds81_t *wxr = refcon;
+    
+    if(!wxr->screen_alloc || wxr->idle_release < 0.f)
+        return RDS_IDLE_CHECK;
+    if(time_get_clock() - wxr->screen_used < wxr->idle_release)
+        return RDS_IDLE_CHECK;
+    
+    gl_state_invalidate();
+    rds81_free_screen(wxr);
+    gl_state_reset();
+    return RDS_IDLE_CHECK;
+}
+
+// Queues a resource for the loader threads, and returns its job. Built-in resources are decoded
+// from memory, the others are read from the resources folder.
+static int rds81_load_resource(gl_load_type_t type, const char *name) {
+    const resource_t *res = resource_find(name);
+    if(res && !resources_on_disk())
+        return loader_add_mem(wxr->loader, type, name, res->data, res->size);
+    
     char *path = fs_make_path(get_plugin_dir(), "resources", name, NULL);
-    int w = 0, h = 0;
-    GLuint tex = gl_load_tex(path, &w, &h);
-    if(tex == 0)
-        log_msg("could not load texture `%s'", path);
+    int job = loader_add(wxr->loader, type, path);
     free(path);
-    return tex;
+    return job;
+}
+
+// Queues an image for the panel's texture atlas, and returns its loader job. See rds81_init().
+// When the atlas was packed at build time, the image is already in it, and this returns its index.
+int rds81_load_image(const char *name) {
+    if(atlas_tex(wxr->atlas))
+        return atlas_find_image(wxr->atlas, name);
+    return rds81_load_resource(LOAD_IMAGE, name);
+}
+
+// Moves an image decoded by the loader into the atlas, and returns its index there.
+static int rds81_atlas_add(int job) {
+    unsigned w = 0, h = 0;
+    uint8_t *data = loader_take_image(wxr->loader, job, &w, &h);
+    return atlas_add_image(wxr->atlas, loader_path(wxr->loader, job), data, w, h);
+}
+
+// Once the loader threads are done, packs the images they decoded into the atlas, unless it was
+// packed at build time.
+static void rds81_finish_loader(rds81_t *wxr) {
+    RDS_TRACE_BEGIN(__func__);
+    if(!atlas_tex(wxr->atlas)) {
+        wxr->bezel_img = rds81_atlas_add(wxr->bezel_img);
+        wxr->dots_img = rds81_atlas_add(wxr->dots_img);
+        wxr->crt_mask_img = rds81_atlas_add(wxr->crt_mask_img);
+        for(int i = 0; i < KNOB_COUNT; ++i)
+            wxr->knobs[i].img = rds81_atlas_add(wxr->knobs[i].img);
+        atlas_build(wxr->atlas);
+    }
+    
+    vec4 dots_uv;
+    atlas_get_uv(wxr->atlas, wxr->dots_img, dots_uv);
+    quad_set_tex(wxr->dots_quad, atlas_tex(wxr->atlas));
+    quad_set_uv(wxr->dots_quad, dots_uv);
+    
+    loader_destroy(wxr->loader);
+    wxr->loader = NULL;
+    RDS_TRACE_END(__func__);
+}
+
+// Picks up the resources started at init as they become available: the images and font from the
+// loader threads, and the programs the driver links in the background. Until they're all in, the
+// screen stays dark and the warm-up doesn't start.
+static void rds81_poll_resources(rds81_t *wxr) {
+    if(wxr->ready)
+        return;
+    if(wxr->loader && loader_done(wxr->loader))
+        rds81_finish_loader(wxr);
+    if(!wxr->shaders_ready && rds81_shaders_linked())
+        rds81_end_shaders();
+    if(wxr->loader || !wxr->shaders_ready)
+        return;
+    
+    rds81_set_mask_rect();
+    wxr->ready = true;
 }
 
 cursor_t* rds81_load_cursor(const char *name) {
@@ -387,7 +914,15 @@ static int reload_shaders_cmd(XPLMCommandRef ref, XPLMCommandPhase phase, void *
     UNUSED(ptr);
     
     if(wxr != NULL) {
-        rds81_reload_shaders();
+        gl_state_invalidate();
+        // Shaders are reloaded from the resources folder, so they can be edited in place.
+        resources_set_disk(true);
+        gl_progcache_invalidate();
+        rds81_begin_shaders();
+        rds81_end_shaders();
+        if(wxr->ready)
+            rds81_set_mask_rect();
+        gl_state_reset();
     }
     return 1;
 }
@@ -399,13 +934,6 @@ void rds81_init(rds81_side_t side) {
     if(wxr != NULL)
         return;
     wxr = safe_calloc(1, sizeof(*wxr));
-    wxr->vg = nvgCreateGL2(NVG_ANTIALIAS);
-    
-    // char *font_path = fs_make_path(get_plugin_dir(), "resources", "MonomaniacOne-Regular.ttf", NULL);
-    char *font_path = fs_make_path(get_plugin_dir(), "resources", "Roboto-Bold.ttf", NULL);
-    int res = nvgCreateFont(wxr->vg, "default", font_path);
-    free(font_path);
-    log_msg("font load: %d", res);
     
     wxr->wxr_tex_id = side == RDS81_SIDE_COPILOT ? xplm_Tex_Radar_Copilot : xplm_Tex_Radar_Pilot;
     
@@ -418,21 +946,21 @@ void rds81_init(rds81_side_t side) {
     
     wxr->dr_avionics_power = find_dr_safe("sim/cockpit2/switches/avionics_power_on");
     
-    wxr->dr_mode = find_dr_safe("sim/cockpit2/EFIS/EFIS_weather_mode%s", side_str);
+    dr_shadow_init(&wxr->dr_mode, find_dr_safe("sim/cockpit2/EFIS/EFIS_weather_mode%s", side_str));
     wxr->dr_tilt = find_dr_safe("sim/cockpit2/EFIS/EFIS_weather_tilt", side_str);
     wxr->dr_tilt_antenna = find_dr_safe("sim/cockpit2/EFIS/EFIS_weather_tilt_antenna%s", side_str);
-    wxr->dr_auto_tilt = find_dr_safe("sim/cockpit2/EFIS/EFIS_weather_auto_tilt%s", side_str);
-    wxr->dr_gain = find_dr_safe("sim/cockpit2/EFIS/EFIS_weather_gain%s", side_str);
+    dr_shadow_init(&wxr->dr_auto_tilt, find_dr_safe("sim/cockpit2/EFIS/EFIS_weather_auto_tilt%s", side_str));
+    dr_shadow_init(&wxr->dr_gain, find_dr_safe("sim/cockpit2/EFIS/EFIS_weather_gain%s", side_str));
     
     wxr->dr_stab = find_dr_safe("sim/cockpit2/EFIS/EFIS_weather_stab%s", side_str);
-    wxr->dr_gcs = find_dr_safe("sim/cockpit2/EFIS/EFIS_weather_gcs%s", side_str);
-    wxr->dr_pws = find_dr_safe("sim/cockpit2/EFIS/EFIS_weather_pws");
-    wxr->dr_multiscan = find_dr_safe("sim/cockpit2/EFIS/EFIS_weather_multiscan%s", side_str);
-    wxr->dr_vertical = find_dr_safe("sim/cockpit2/EFIS/EFIS_weather_vertical%s", side_str);
+    dr_shadow_init(&wxr->dr_gcs, find_dr_safe("sim/cockpit2/EFIS/EFIS_weather_gcs%s", side_str));
+    dr_shadow_init(&wxr->dr_pws, find_dr_safe("sim/cockpit2/EFIS/EFIS_weather_pws"));
+    dr_shadow_init(&wxr->dr_multiscan, find_dr_safe("sim/cockpit2/EFIS/EFIS_weather_multiscan%s", side_str));
+    dr_shadow_init(&wxr->dr_vertical, find_dr_safe("sim/cockpit2/EFIS/EFIS_weather_vertical%s", side_str));
     
-    wxr->dr_sector_brg = find_dr_safe("sim/cockpit2/EFIS/EFIS_weather_sector_brg");
-    wxr->dr_sector_width = find_dr_safe("sim/cockpit2/EFIS/EFIS_weather_sector_width");
-    wxr->dr_antenna_limit = find_dr_safe("sim/cockpit2/EFIS/EFIS_weather_antenna_limit");
+    dr_shadow_init(&wxr->dr_sector_brg, find_dr_safe("sim/cockpit2/EFIS/EFIS_weather_sector_brg"));
+    dr_shadow_init(&wxr->dr_sector_width, find_dr_safe("sim/cockpit2/EFIS/EFIS_weather_sector_width"));
+    dr_shadow_init(&wxr->dr_antenna_limit, find_dr_safe("sim/cockpit2/EFIS/EFIS_weather_antenna_limit"));
     
     wxr->dr_range_idx = find_dr_safe("sim/cockpit2/EFIS/map_range%s", side_str);
     wxr->dr_range = find_dr_safe("sim/cockpit2/EFIS/map_range_nm%s", side_str);
@@ -443,20 +971,37 @@ void rds81_init(rds81_side_t side) {
     
     rds81_bind_commands(wxr);
     
-    // Allocate the OpenGL resources we need
-    rds81_reload_shaders();
-    
-    wxr->wxr_fbo = gl_fbo_new(RDS_WXR_BUF_W, RDS_WXR_BUF_H, &wxr->wxr_tex);
-    wxr->screen_fbo = gl_fbo_new(RDS_SCREEN_W/2, RDS_SCREEN_H/2, &wxr->screen_tex);
-    wxr->bezel_tex = rds81_load_tex("bezel.png");
-    wxr->dots_tex = rds81_load_tex("dots.png");
-    wxr->crt_mask_tex = rds81_load_tex("crt_mask.png");
-    
-    wxr->src_quad = quad_new(0, wxr->shader_ant);
-    wxr->bezel_quad = quad_new(wxr->bezel_tex, 0);
-    wxr->screen_quad = quad_new(wxr->screen_tex, wxr->shader_screen);
-    wxr->dots_quad = quad_new(wxr->dots_tex, 0);
-    wxr->wxr_quad = quad_new(wxr->wxr_tex, wxr->shader_wxr);
+    // The bezel, knob and overlay images are loaded on worker threads while we get on with the
+    // rest. The images end up packed into a single texture, see rds81_poll_resources().
+    // If texconv packed them when the plugin was built, the atlas is uploaded as it is instead.
+    wxr->loader = loader_new();
+    wxr->atlas = atlas_new(RDS_ATLAS_W, RDS_ATLAS_PAD);
+    const resource_t *panel = resource_find("panel.rtex");
+    if(panel && !resources_on_disk())
+        atlas_load(wxr->atlas, panel->data, panel->size);
+    wxr->bezel_img = rds81_load_image("bezel.png");
+    wxr->dots_img = rds81_load_image("dots.png");
+    wxr->crt_mask_img = rds81_load_image("crt_mask.png");
+    rds81_init_kn_butt(wxr);
+    loader_start(wxr->loader, RDS_LOADER_THREADS);
+    
+    // Allocate the OpenGL resources we need.
+    gl_state_invalidate();
+    // The radar shaders only use uniform buffers in their GL 4.2 variants, see
+    // rds81_begin_shader().
+    wxr->params = gl_block_new(&rds_params_desc, GLEW_VERSION_4_2);
+    rds81_init_progcache();
+    rds81_begin_shaders();
+    
+    // The screen's own resources wait until it's first turned on, see rds81_alloc_screen().
+    wxr->bezel_batch = batch_new(RDS_BEZEL_SPRITES);
+    wxr->dots_quad = quad_new(0, 0);
+    wxr->idle_release = RDS_IDLE_RELEASE;
+    XPLMRegisterFlightLoopCallback(rds81_idle_floop, RDS_IDLE_CHECK, wxr);
+#ifdef RDS_PROFILE
+    rds81_perf_init();
+    rds81_trace_init();
+#endif
     
     wxr->cur_click = rds81_load_cursor("cursor_click.png");
     wxr->cur_rotate_left = rds81_load_cursor("cursor_rot_left.png");
@@ -487,8 +1032,7 @@ void rds81_init(rds81_side_t side) {
     };
     wxr->device = XPLMCreateAvionicsEx(&desc);
     ASSERT(wxr->device != NULL);
-    
-    rds81_init_kn_butt(wxr);
+    gl_state_reset();
     
     wxr->mode = RDS81_MODE_OFF;
     wxr->submode = RDS81_SUBMODE_WX;
@@ -497,7 +1041,6 @@ void rds81_init(rds81_side_t side) {
     wxr->map_gain = 1.f;
     
     wxr->ant_angle = -RDS_ANT_LIM;
-    wxr->ant_angle_last = -RDS_ANT_LIM;
     wxr->ant_dir = 1;
     wxr->ant_clear = true;
     
@@ -528,24 +1071,34 @@ void rds81_fini() {
     XPLMUnregisterCommandHandler(wxr_out.cmd_popup, handle_popup, 0, wxr);
     XPLMUnregisterCommandHandler(wxr_out.cmd_popout, handle_popout, 0, wxr);
     
-    quad_destroy(wxr->bezel_quad);
-    quad_destroy(wxr->screen_quad);
-    quad_destroy(wxr->dots_quad);
-    quad_destroy(wxr->wxr_quad);
-    quad_destroy(wxr->src_quad);
+    XPLMUnregisterFlightLoopCallback(rds81_idle_floop, wxr);
     
-    glDeleteProgram(wxr->shader_screen);
-    glDeleteProgram(wxr->shader_wxr);
-    glDeleteProgram(wxr->shader_ant);
-    glDeleteProgram(wxr->shader_test);
+    gl_state_invalidate();
+    // Programs still linking are waited for, so that everything below exists.
+    if(!wxr->shaders_ready)
+        rds81_end_shaders();
+    rds81_free_screen(wxr);
+    batch_destroy(wxr->bezel_batch);
+    quad_destroy(wxr->dots_quad);
     
-    glDeleteTextures(1, &wxr->wxr_tex);
-    glDeleteTextures(1, &wxr->dots_tex);
-    glDeleteTextures(1, &wxr->screen_tex);
-    glDeleteTextures(1, &wxr->bezel_tex);
-    glDeleteTextures(1, &wxr->crt_mask_tex);
-    glDeleteFramebuffers(1, &wxr->wxr_fbo);
-    glDeleteFramebuffers(1, &wxr->screen_fbo);
+    gl_program_fini(&wxr->shader_screen);
+    gl_program_fini(&wxr->shader_wxr);
+    gl_program_fini(&wxr->shader_ant);
+    gl_program_fini(&wxr->shader_test);
+    gl_program_fini(&wxr->shader_polar);
+    gl_program_fini(&wxr->shader_scan);
+    gl_program_fini(&wxr->shader_atten);
+    gl_program_fini(&wxr->shader_atten_cs);
+    gl_block_destroy(wxr->params);
+#ifdef RDS_PROFILE
+    rds81_trace_fini();
+    rds81_perf_fini();
+#endif
+    gl_progcache_fini();
+    if(wxr->loader)
+        loader_destroy(wxr->loader);
+    atlas_destroy(wxr->atlas);
+    gl_state_reset();
     
     if(wxr->cur_click)
         cursor_free(wxr->cur_click);
@@ -555,7 +1108,6 @@ void rds81_fini() {
         cursor_free(wxr->cur_rotate_right);
     
     XPLMDestroyAvionics(wxr->device);
-    nvgDeleteGL2(wxr->vg);
     wxr = NULL;
     free(wxr);
 }
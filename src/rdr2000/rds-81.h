@@ -39,4 +39,24 @@ rds81_side_t rds81_find_best_side();
 void rds81_init(rds81_side_t side);
 void rds81_fini();
 
+// Sent to the plugin, with a rds81_bench_t as its parameter, to time each of the radar's GPU passes
+// on its own (see src/xphost/gpu_bench.c). It must be sent from the thread that owns the GL
+// context, between frames. Results are written as JSON to `path`, or stdout if it is NULL. Only
+// profiling builds (RDR_PROFILE, or RDR_BUILD_HOST) handle it; release plugins ignore it.
+#define RDS81_MSG_GPU_BENCH 0x52440001
+
+typedef enum {
+    RDS81_BENCH_NOT_READY,
+    RDS81_BENCH_DONE,
+    RDS81_BENCH_FAILED,
+} rds81_bench_status_t;
+
+typedef struct {
+    unsigned                iterations;
+    const char              *path;
+    rds81_bench_status_t    status;
+} rds81_bench_t;
+
+void rds81_gpu_bench(rds81_bench_t *bench);
+
 #endif /* ifndef _RDS_81_H_ */
@@ -0,0 +1,220 @@
+/*===--------------------------------------------------------------------------------------------===
+ * rds-81_bench.c
+ *
+ * Created by Amy Parent <amy@amyparent.com>
+ * Copyright (c) 2024 Laminar Research. All rights reserved
+ *
+ * Licensed under the MIT License
+ *===--------------------------------------------------------------------------------------------===
+*/
+#include "rds-81_impl.h"
+
+#ifdef RDS_PROFILE
+
+#include <cglm/mat4.h>
+#include <stdio.h>
+
+// Times each of the screen's GPU passes on its own, with one GL_TIME_ELAPSED query per iteration.
+// Every pass covers the whole antenna sweep, rather than the wedge of a single step, so that the
+// numbers don't depend on the frame rate and can be compared from one build to the next.
+
+// The antenna pass is timed at each range, since the attenuation scales with it.
+static const float bench_ranges[] = {10, 20, 40, 80, 160, 320, 640};
+
+typedef struct {
+    unsigned    iterations;
+    GLuint      *queries;
+    FILE        *out;
+    bool        first;
+
+    GLuint      src_tex;
+    GLuint      atten_tex;
+    GLuint      screen_fbo;
+    GLuint      screen_tex;
+    mat4        polar_ortho;
+    mat4        screen_ortho;
+} bench_t;
+
+typedef void (*bench_pass_f)(bench_t *bench);
+
+static void bench_polar_target() {
+    glViewport(0, 0, RDS_WXR_POLAR_W, RDS_WXR_POLAR_H);
+    glEnable(GL_SCISSOR_TEST);
+}
+
+static void bench_polar(bench_t *bench) {
+    bench_polar_target();
+    rds81_pass_polar(bench->src_tex, -RDS_ANT_LIM, RDS_ANT_LIM, bench->polar_ortho);
+    glDisable(GL_SCISSOR_TEST);
+}
+
+static void bench_atten(bench_t *bench) {
+    bench_polar_target();
+    bench->atten_tex = rds81_update_atten(-RDS_ANT_LIM, RDS_ANT_LIM, bench->polar_ortho);
+    glDisable(GL_SCISSOR_TEST);
+}
+
+static void bench_antenna(bench_t *bench) {
+    bench_polar_target();
+    rds81_pass_sweep(&wxr->shader_ant, bench->atten_tex, -RDS_ANT_LIM, RDS_ANT_LIM,
+                     bench->polar_ortho);
+    glDisable(GL_SCISSOR_TEST);
+}
+
+static void bench_test(bench_t *bench) {
+    bench_polar_target();
+    rds81_pass_sweep(&wxr->shader_test, 0, -RDS_ANT_LIM, RDS_ANT_LIM, bench->polar_ortho);
+    glDisable(GL_SCISSOR_TEST);
+}
+
+static void bench_scan(bench_t *bench) {
+    UNUSED(bench);
+    rds81_pass_scan(-RDS_ANT_LIM, RDS_ANT_LIM);
+}
+
+static void bench_overlay(bench_t *bench) {
+    UNUSED(bench);
+    wxr->overlay_valid = false;
+    rds81_update_overlay(wxr);
+}
+
+static void bench_copy(bench_t *bench) {
+    glBindFramebuffer(GL_FRAMEBUFFER, wxr->screen_fbo);
+    glViewport(0, 0, RDS_SCREEN_W/2, RDS_SCREEN_H/2);
+    rds81_pass_copy(bench->screen_ortho);
+}
+
+static void bench_screen(bench_t *bench) {
+    glBindFramebuffer(GL_FRAMEBUFFER, bench->screen_fbo);
+    glViewport(0, 0, RDS_SCREEN_W, RDS_SCREEN_H);
+    rds81_pass_screen(bench->screen_ortho);
+}
+
+// Renderer strings are free-form, so they're escaped before they go in the results.
+static void bench_write_str(FILE *out, const char *str) {
+    fputc('"', out);
+    for(; str && *str; ++str) {
+        if(*str == '"' || *str == '\\')
+            fputc('\\', out);
+        if((unsigned char)*str >= 0x20)
+            fputc(*str, out);
+    }
+    fputc('"', out);
+}
+
+// Runs `pass` once to get it out of the driver's way, then `iterations` times under timer queries,
+// and writes its result. Each pass is one line of JSON, so that two runs diff cleanly.
+static void bench_run(bench_t *bench, const char *name, float range, bench_pass_f pass) {
+    pass(bench);
+    for(unsigned i = 0; i < bench->iterations; ++i) {
+        glBeginQuery(GL_TIME_ELAPSED, bench->queries[i]);
+        pass(bench);
+        glEndQuery(GL_TIME_ELAPSED);
+    }
+
+    double total = 0.0, min = INFINITY, max = 0.0;
+    for(unsigned i = 0; i < bench->iterations; ++i) {
+        GLuint64 ns = 0;
+        glGetQueryObjectui64v(bench->queries[i], GL_QUERY_RESULT, &ns);
+        double us = ns * 1e-3;
+        total += us;
+        min = MIN(min, us);
+        max = MAX(max, us);
+    }
+
+    fprintf(bench->out, "%s\n    {\"pass\": \"%s\", ", bench->first ? "" : ",", name);
+    if(range > 0.f)
+        fprintf(bench->out, "\"range_nm\": %.0f, ", range);
+    fprintf(bench->out, "\"mean_us\": %.3f, \"min_us\": %.3f, \"max_us\": %.3f}",
+            total / bench->iterations, min, max);
+    bench->first = false;
+}
+
+static void bench_passes(bench_t *bench) {
+    // The antenna pass samples the attenuation scan, so the scan runs first.
+    bench_run(bench, "wxr_polar", 0.f, bench_polar);
+    bench_run(bench, wxr->shader_atten_cs.id ? "wxr_atten" : "wxr_atten_scan", 0.f, bench_atten);
+    for(unsigned i = 0; i < sizeof(bench_ranges) / sizeof(bench_ranges[0]); ++i) {
+        wxr->inputs.range = bench_ranges[i];
+        rds81_update_params(wxr);
+        bench_run(bench, "wxr_antenna", bench_ranges[i], bench_antenna);
+    }
+    bench_run(bench, "wxr_test", 0.f, bench_test);
+    bench_run(bench, "wxr_scan", 0.f, bench_scan);
+    bench_run(bench, "overlay", 0.f, bench_overlay);
+    bench_run(bench, "wxr_copy", 0.f, bench_copy);
+    bench_run(bench, "rdr_screen", 0.f, bench_screen);
+}
+
+void rds81_gpu_bench(rds81_bench_t *req) {
+    ASSERT(req != NULL);
+    if(wxr == NULL || !wxr->ready) {
+        req->status = RDS81_BENCH_NOT_READY;
+        return;
+    }
+    if(!GLEW_VERSION_3_3 && !GLEW_ARB_timer_query) {
+        log_msg("GPU bench: timer queries are not supported");
+        req->status = RDS81_BENCH_FAILED;
+        return;
+    }
+    FILE *out = req->path ? fopen(req->path, "w") : stdout;
+    if(!out) {
+        log_msg("GPU bench: cannot write `%s`", req->path);
+        req->status = RDS81_BENCH_FAILED;
+        return;
+    }
+
+    XPLMSetGraphicsState(0, 2, 0, 1, 1, 0, 0);
+    gl_state_invalidate();
+    if(!wxr->screen_alloc)
+        rds81_alloc_screen(wxr);
+
+    // The overlay is drawn as it would be in WX mode, and restored afterwards.
+    rds81_mode_t mode = wxr->mode;
+    float range = wxr->inputs.range;
+    wxr->mode = RDS81_MODE_ON;
+
+    bench_t bench = {
+        .iterations = MAX(req->iterations, 1),
+        .out = out,
+        .first = true,
+        .src_tex = XPLMGetTexture(wxr->wxr_tex_id),
+        .atten_tex = wxr->atten_tex[0],
+    };
+    bench.queries = safe_calloc(bench.iterations, sizeof(GLuint));
+    glGenQueries(bench.iterations, bench.queries);
+    bench.screen_fbo = gl_fbo_new(RDS_SCREEN_W, RDS_SCREEN_H, &bench.screen_tex);
+    glm_ortho(0, RDS_WXR_POLAR_W, 0, RDS_WXR_POLAR_H, -1, 1, bench.polar_ortho);
+    glm_ortho(0, RDS_SCREEN_W, 0, RDS_SCREEN_H, -1, 1, bench.screen_ortho);
+
+    fprintf(out, "{\n  \"renderer\": ");
+    bench_write_str(out, (const char *)glGetString(GL_RENDERER));
+    fprintf(out, ",\n  \"version\": ");
+    bench_write_str(out, (const char *)glGetString(GL_VERSION));
+    fprintf(out, ",\n  \"iterations\": %u,\n  \"passes\": [", bench.iterations);
+    bench_passes(&bench);
+    fprintf(out, "\n  ]\n}\n");
+    if(out != stdout)
+        fclose(out);
+    else
+        fflush(out);
+
+    glDeleteQueries(bench.iterations, bench.queries);
+    glDeleteTextures(1, &bench.screen_tex);
+    glDeleteFramebuffers(1, &bench.screen_fbo);
+    free(bench.queries);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+    // Everything the passes drew into is stale now.
+    wxr->mode = mode;
+    wxr->inputs.range = range;
+    wxr->ant_clear = true;
+    wxr->overlay_valid = false;
+    wxr->screen_used = time_get_clock();
+    gl_state_reset();
+
+    log_msg("GPU bench: timed %u iterations of each pass", bench.iterations);
+    req->status = RDS81_BENCH_DONE;
+}
+
+#endif /* RDS_PROFILE */
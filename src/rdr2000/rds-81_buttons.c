@@ -97,19 +97,12 @@ void rds81_init_kn_butt(rds81_t *wxr) {
         ASSERT(knob->cmd_dn != NULL);
         ASSERT(knob->val != NULL);
         
-        knob->tex = rds81_load_tex(desc->tex);
-        knob->quad = quad_new(knob->tex, 0);
+        knob->img = rds81_load_image(desc->tex);
     }
 }
 
 void rds81_fini_kn_butt(rds81_t *wxr) {
     wxr->act_cmd = NULL;
-    
-    for(int i = 0; i < KNOB_COUNT; ++i) {
-        knob_t *knob = &wxr->knobs[i];
-        quad_destroy(knob->quad);
-        glDeleteTextures(1, &knob->tex);
-    }
 }
 
 static bool vec2_in_rect(const vec2 click, const vec2 pos, const vec2 size) {
@@ -17,43 +17,52 @@ static inline float roundN(float val, int n) {
 static int handle_submode_wx(XPLMCommandRef cmd, XPLMCommandPhase phase, void *refcon) {
     rds81_t *wxr = refcon;
     ASSERT(wxr != NULL);
+    RDS_TRACE_BEGIN(__func__);
     if(phase == xplm_CommandBegin) {
         wxr->submode = RDS81_SUBMODE_WX;
     }
+    RDS_TRACE_END(__func__);
     return 1;
 }
 
 static int handle_submode_wxa(XPLMCommandRef cmd, XPLMCommandPhase phase, void *refcon) {
     rds81_t *wxr = refcon;
     ASSERT(wxr != NULL);
+    RDS_TRACE_BEGIN(__func__);
     if(phase == xplm_CommandBegin) {
         wxr->submode = RDS81_SUBMODE_WXA;
     }
+    RDS_TRACE_END(__func__);
     return 1;
 }
 
 static int handle_submode_map(XPLMCommandRef cmd, XPLMCommandPhase phase, void *refcon) {
     rds81_t *wxr = refcon;
     ASSERT(wxr != NULL);
+    RDS_TRACE_BEGIN(__func__);
     if(phase == xplm_CommandBegin) {
         wxr->submode = RDS81_SUBMODE_MAP;
     }
+    RDS_TRACE_END(__func__);
     return 1;
 }
 
 static int handle_stab(XPLMCommandRef cmd, XPLMCommandPhase phase, void *refcon) {
     rds81_t *wxr = refcon;
     ASSERT(wxr != NULL);
+    RDS_TRACE_BEGIN(__func__);
     if(phase == xplm_CommandBegin) {
         int stab = !XPLMGetDatai(wxr->dr_stab);
         XPLMSetDatai(wxr->dr_stab, stab);
     }
+    RDS_TRACE_END(__func__);
     return 1;
 }
 
 static int handle_range_buttons(XPLMCommandRef cmd, XPLMCommandPhase phase, void *refcon) {
     rds81_t *wxr = refcon;
     ASSERT(wxr != NULL);
+    RDS_TRACE_BEGIN(__func__);
     if(phase == xplm_CommandBegin) {
         int range = XPLMGetDatai(wxr->dr_range_idx);
         int old_range = range;
@@ -65,68 +74,81 @@ static int handle_range_buttons(XPLMCommandRef cmd, XPLMCommandPhase phase, void
         wxr->ant_clear = range != old_range;
         XPLMSetDatai(wxr->dr_range_idx, range);
     }
+    RDS_TRACE_END(__func__);
     return 1;
 }
 
 static int handle_mode_up(XPLMCommandRef cmd, XPLMCommandPhase phase, void *refcon) {
     rds81_t *wxr = refcon;
     ASSERT(wxr != NULL);
+    RDS_TRACE_BEGIN(__func__);
     if(phase == xplm_CommandBegin) {
         int mode = CLAMP((int)wxr->mode + 1, 0, 3);
         wxr->ant_clear = wxr->mode != mode;
         wxr->mode = mode;
     }
+    RDS_TRACE_END(__func__);
     return 1;
 }
 
 static int handle_mode_dn(XPLMCommandRef cmd, XPLMCommandPhase phase, void *refcon) {
     rds81_t *wxr = refcon;
     ASSERT(wxr != NULL);
+    RDS_TRACE_BEGIN(__func__);
     if(phase == xplm_CommandBegin) {
         int mode = CLAMP((int)wxr->mode - 1, 0, 3);
         wxr->ant_clear = wxr->mode != mode;
         wxr->mode = mode;
     }
+    RDS_TRACE_END(__func__);
     return 1;
 }
 
 static int handle_off(XPLMCommandRef cmd, XPLMCommandPhase phase, void *refcon) {
     rds81_t *wxr = refcon;
     ASSERT(wxr != NULL);
+    RDS_TRACE_BEGIN(__func__);
     if(phase == xplm_CommandBegin) {
         wxr->mode = RDS81_MODE_OFF;
         wxr->ant_clear = true;
     }
+    RDS_TRACE_END(__func__);
     return 1;
 }
 
 static int handle_stby(XPLMCommandRef cmd, XPLMCommandPhase phase, void *refcon) {
     rds81_t *wxr = refcon;
     ASSERT(wxr != NULL);
+    RDS_TRACE_BEGIN(__func__);
     if(phase == xplm_CommandBegin) {
         wxr->mode = RDS81_MODE_STBY;
         wxr->ant_clear = true;
     }
+    RDS_TRACE_END(__func__);
     return 1;
 }
 
 static int handle_test(XPLMCommandRef cmd, XPLMCommandPhase phase, void *refcon) {
     rds81_t *wxr = refcon;
     ASSERT(wxr != NULL);
+    RDS_TRACE_BEGIN(__func__);
     if(phase == xplm_CommandBegin) {
         wxr->ant_clear = wxr->mode != RDS81_MODE_TEST;
         wxr->mode = RDS81_MODE_TEST;
     }
+    RDS_TRACE_END(__func__);
     return 1;
 }
 
 static int handle_on(XPLMCommandRef cmd, XPLMCommandPhase phase, void *refcon) {
     rds81_t *wxr = refcon;
     ASSERT(wxr != NULL);
+    RDS_TRACE_BEGIN(__func__);
     if(phase == xplm_CommandBegin) {
         wxr->ant_clear = wxr->mode != RDS81_MODE_ON;
         wxr->mode = RDS81_MODE_ON;
     }
+    RDS_TRACE_END(__func__);
     return 1;
 }
 
@@ -134,64 +156,76 @@ static int handle_on(XPLMCommandRef cmd, XPLMCommandPhase phase, void *refcon) {
 static int handle_tilt_up(XPLMCommandRef cmd, XPLMCommandPhase phase, void *refcon) {
     rds81_t *wxr = refcon;
     ASSERT(wxr != NULL);
+    RDS_TRACE_BEGIN(__func__);
     if(phase != xplm_CommandEnd) {
         float inc = 0.05f;
         float tilt = XPLMGetDataf(wxr->dr_tilt);
         XPLMSetDataf(wxr->dr_tilt, CLAMP(tilt + inc, -15.f, 15.f));
     }
+    RDS_TRACE_END(__func__);
     return 1;
 }
 
 static int handle_tilt_dn(XPLMCommandRef cmd, XPLMCommandPhase phase, void *refcon) {
     rds81_t *wxr = refcon;
     ASSERT(wxr != NULL);
+    RDS_TRACE_BEGIN(__func__);
     if(phase != xplm_CommandEnd) {
         float inc = 0.05f;
         float tilt = XPLMGetDataf(wxr->dr_tilt);
         XPLMSetDataf(wxr->dr_tilt, CLAMP(tilt - inc, -15.f, 15.f));
     }
+    RDS_TRACE_END(__func__);
     return 1;
 }
 
 static int handle_gain_up(XPLMCommandRef cmd, XPLMCommandPhase phase, void *refcon) {
     rds81_t *wxr = refcon;
     ASSERT(wxr != NULL);
+    RDS_TRACE_BEGIN(__func__);
     if(phase != xplm_CommandEnd) {
         float inc = 0.02f;
         wxr->map_gain = CLAMP(wxr->map_gain + inc, 0.f, 1.f);
     }
+    RDS_TRACE_END(__func__);
     return 1;
 }
 
 static int handle_gain_dn(XPLMCommandRef cmd, XPLMCommandPhase phase, void *refcon) {
     rds81_t *wxr = refcon;
     ASSERT(wxr != NULL);
+    RDS_TRACE_BEGIN(__func__);
     if(phase != xplm_CommandEnd) {
         float inc = 0.02f;
         wxr->map_gain = CLAMP(wxr->map_gain - inc, 0.f, 1.f);
     }
+    RDS_TRACE_END(__func__);
     return 1;
 }
 
 static int handle_brt_up(XPLMCommandRef cmd, XPLMCommandPhase phase, void *refcon) {
     rds81_t *wxr = refcon;
     ASSERT(wxr != NULL);
+    RDS_TRACE_BEGIN(__func__);
     if(phase != xplm_CommandEnd) {
         float inc = 0.01f;
         float brt = XPLMGetAvionicsBrightnessRheo(wxr->device);
         XPLMSetAvionicsBrightnessRheo(wxr->device, CLAMP(brt + inc, 0.f, 1.f));
     }
+    RDS_TRACE_END(__func__);
     return 1;
 }
 
 static int handle_brt_dn(XPLMCommandRef cmd, XPLMCommandPhase phase, void *refcon) {
     rds81_t *wxr = refcon;
     ASSERT(wxr != NULL);
+    RDS_TRACE_BEGIN(__func__);
     if(phase != xplm_CommandEnd) {
         float inc = 0.01f;
         float brt = XPLMGetAvionicsBrightnessRheo(wxr->device);
         XPLMSetAvionicsBrightnessRheo(wxr->device, CLAMP(brt - inc, 0.f, 1.f));
     }
+    RDS_TRACE_END(__func__);
     return 1;
 }
 
@@ -311,6 +345,22 @@ static void set_brt(void *ptr, float val) {
     XPLMSetAvionicsBrightnessRheo(wxr->device, CLAMP(val, 0.f, 1.f));
 }
 
+static float get_idle_release(void *ptr) {
+    UNUSED(ptr);
+    if(!wxr)
+        return RDS_IDLE_RELEASE;
+    return wxr->idle_release;
+}
+
+// How long (in seconds) the screen's GPU resources are kept once the radar is off, unpowered or
+// out of sight. A negative value keeps them until the plugin is disabled.
+static void set_idle_release(void *ptr, float val) {
+    UNUSED(ptr);
+    if(!wxr)
+        return;
+    wxr->idle_release = val;
+}
+
 void rds81_declare_cmd_dr() {
     wxr_out.cmd_popup = XPLMCreateCommand(DR_CMD_PREFIX "rdr2000/popup", "RDR2000 popup");
     wxr_out.cmd_popout = XPLMCreateCommand(DR_CMD_PREFIX "rdr2000/popout", "RDR2000 pop out window");
@@ -343,6 +393,8 @@ void rds81_declare_cmd_dr() {
     wxr_out.dr_brt = create_dr_f(get_brt, set_brt, NULL, DR_CMD_PREFIX "rdr2000/brightness");
     wxr_out.dr_tilt = create_dr_f(get_tilt, set_tilt, NULL, DR_CMD_PREFIX "rdr2000/tilt");
     wxr_out.dr_gain = create_dr_f(get_gain, set_gain, NULL, DR_CMD_PREFIX "rdr2000/gain");
+    wxr_out.dr_idle_release = create_dr_f(get_idle_release, set_idle_release, NULL,
+                                          DR_CMD_PREFIX "rdr2000/idle_release");
 }
 
 void rds81_unbind_dr_cmd() {
@@ -350,11 +402,13 @@ void rds81_unbind_dr_cmd() {
     XPLMUnregisterDataAccessor(wxr_out.dr_gain);
     XPLMUnregisterDataAccessor(wxr_out.dr_tilt);
     XPLMUnregisterDataAccessor(wxr_out.dr_brt);
+    XPLMUnregisterDataAccessor(wxr_out.dr_idle_release);
     
     wxr_out.dr_mode = NULL;
     wxr_out.dr_gain = NULL;
     wxr_out.dr_tilt = NULL;
     wxr_out.dr_brt = NULL;
+    wxr_out.dr_idle_release = NULL;
     
     memset(&wxr_out, 0, sizeof(wxr_out));
 }
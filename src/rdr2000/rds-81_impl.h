@@ -13,14 +13,20 @@
 #include "rds-81.h"
 
 #include "cursor.h"
+#include "resources.h"
 #include "time_sys.h"
 #include "xplane.h"
 
+#include <glutils/atlas.h>
+#include <glutils/batch.h>
 #include <glutils/gl.h>
+#include <glutils/loader.h>
+#include <glutils/progcache.h>
+#include <glutils/program.h>
 #include <glutils/renderer.h>
+#include <glutils/text.h>
 #include <helpers/helpers.h>
 
-#include <nanovg.h>
 #include <XPLMDisplay.h>
 #include <XPLMGraphics.h>
 
@@ -37,6 +43,11 @@
 #define RDS_WARMUP_SCALE    8.f
 #define RDS_WARMUP_ANTENNA  8.f
 
+// The antenna is moved, and the sweep passes run, at most this many times per second. A long frame
+// catches up on at most RDS_SWEEP_MAX_LAG seconds of scan.
+#define RDS_SWEEP_RATE      25.f
+#define RDS_SWEEP_MAX_LAG   0.5f
+
 #define RDS_SCREEN_W        640
 #define RDS_SCREEN_H        480
 #define RDS_BEZEL_W         1024
@@ -45,12 +56,102 @@
 #define RDS_WXR_BUF_W       (RDS_SCREEN_W/2.f)
 #define RDS_WXR_BUF_H       (RDS_SCREEN_H/2.f)
 
+// The polar buffers have one column per azimuth bin and one row per range bin. They cover a bit
+// more than the antenna limit on either side, so the smearing has data to pull from, and enough
+// range to reach the corners of the cartesian buffer (1.0 is the full selected range).
+#define RDS_WXR_SMEAR_LIM   6.f
+#define RDS_WXR_POLAR_W     512
+#define RDS_WXR_POLAR_H     320
+#define RDS_WXR_POLAR_LIM   (RDS_ANT_LIM + RDS_WXR_SMEAR_LIM)
+#define RDS_WXR_POLAR_DIST  1.21f
+
 #define RDS_SCREEN_OFF_X    192
 #define RDS_SCREEN_OFF_Y    100
 
 #define BUTTON_COUNT    (6)
 #define KNOB_COUNT      (4)
 
+// The bezel and every knob are drawn as one sprite batch.
+#define RDS_BEZEL_SPRITES   (1 + KNOB_COUNT)
+// The overlay's text is one batch too, with one sprite per character.
+#define RDS_TEXT_SPRITES    (64)
+#define RDS_FONT_SIZE       (30.f)
+
+// Every image the panel draws is packed in one atlas. The bezel is the widest image.
+#define RDS_ATLAS_W         (RDS_BEZEL_W + 2 * RDS_ATLAS_PAD)
+#define RDS_ATLAS_PAD       (8)
+
+#define RDS_LOADER_THREADS  (4)
+
+// The screen's buffers are released once the radar has been off, unpowered or out of sight for
+// this many seconds (see rds81_alloc_screen()). It can be changed through rdr2000/idle_release.
+#define RDS_IDLE_RELEASE    (30.f)
+#define RDS_IDLE_CHECK      (1.f)
+
+// CPU and GPU timings of the stages of a frame, published as rdr2000/perf/* datarefs (see
+// rds-81_perf.c). They're only built in with RDS_PROFILE, otherwise the macros compile to nothing.
+typedef enum {
+    RDS_PERF_SCREEN,
+    RDS_PERF_BEZEL,
+    RDS_PERF_UPDATE,
+    RDS_PERF_WXR_TEX,
+    RDS_PERF_DRAW_FBO,
+    RDS_PERF_COUNT,
+} rds_perf_stage_t;
+
+#ifdef RDS_PROFILE
+void rds81_perf_init(void);
+void rds81_perf_fini(void);
+void rds81_perf_begin(rds_perf_stage_t stage);
+void rds81_perf_end(rds_perf_stage_t stage);
+#define RDS_PERF_BEGIN(stage)   rds81_perf_begin(stage)
+#define RDS_PERF_END(stage)     rds81_perf_end(stage)
+#else
+#define RDS_PERF_BEGIN(stage)
+#define RDS_PERF_END(stage)
+#endif
+
+// Begin and end events for chrome://tracing or Perfetto, recorded while tracing is toggled on with
+// rdr2000/debug/trace_toggle (see rds-81_trace.c). Also only built in with RDS_PROFILE.
+#ifdef RDS_PROFILE
+void rds81_trace_init(void);
+void rds81_trace_fini(void);
+void rds81_trace_event(const char *name, char phase);
+#define RDS_TRACE_BEGIN(name)   rds81_trace_event(name, 'B')
+#define RDS_TRACE_END(name)     rds81_trace_event(name, 'E')
+#else
+#define RDS_TRACE_BEGIN(name)
+#define RDS_TRACE_END(name)
+#endif
+
+// The radar programs, which are linked in the background at init. See rds81_poll_resources().
+#define RDS_PROGRAM_COUNT   (8)
+
+// Mirrors the rds_params uniform block shared by the radar shaders, so it follows std140 rules.
+typedef struct {
+    float           aspect[2];
+    float           polar_lim;
+    float           polar_dist;
+    float           buf_h;
+    float           range;
+    float           gain;
+    float           ant_offset;
+    float           blink;
+    float           scale;
+    float           pad[2];
+} rds_params_t;
+
+// Uniforms that live outside of rds_params, because they change between passes or are samplers.
+typedef enum {
+    RDS_U_STRIDE,
+    RDS_U_COL_START,
+    RDS_U_COL_END,
+    RDS_U_ATTEN,
+    RDS_U_MASK,
+    RDS_U_MASK_RECT,
+    RDS_U_COUNT,
+} rds_uniform_t;
+
 typedef enum {
     RDS81_MODE_OFF,
     RDS81_MODE_STBY,
@@ -64,6 +165,20 @@ typedef enum {
     RDS81_SUBMODE_MAP
 } rds81_submode_t;
 
+// Everything the screen's text overlay depends on. It is only redrawn when one of these changes.
+typedef struct {
+    rds81_mode_t    mode;
+    rds81_submode_t submode;
+    int             stab;
+    float           range;
+    float           tilt;
+} rds_overlay_key_t;
+
+typedef struct {
+    gl_link_t       link;
+    gl_program_t    *prog;
+} rds_link_t;
+
 typedef struct {
     const char  *cmd;
     vec2        pos;
@@ -100,10 +215,21 @@ typedef struct {
     XPLMCommandRef      cmd_dn;
     XPLMDataRef         val;
     
-    GLuint              tex;
-    gl_quad_t           *quad;
+    int                 img;
 } knob_t;
 
+// Everything we read from X-Plane during a frame. It is filled once per sim cycle, by whichever of
+// our callbacks runs first, so each dataref is only read once per frame.
+typedef struct {
+    bool            valid;
+    int             cycle;
+    bool            has_power;
+    int             stab;
+    float           range;
+    float           tilt;
+    float           knobs[KNOB_COUNT];
+} rds81_frame_inputs_t;
+
 typedef struct rds81_out_t {
     XPLMCommandRef  cmd_popup;
     XPLMCommandRef  cmd_popout;
@@ -135,31 +261,62 @@ typedef struct rds81_out_t {
     XPLMDataRef     dr_gain;
     XPLMDataRef     dr_tilt;
     XPLMDataRef     dr_brt;
+    XPLMDataRef     dr_idle_release;
 } rds81_out_t;
 
 typedef struct rds81_t {
     GLuint          wxr_fbo;
     GLuint          wxr_tex;
+    GLuint          polar_src_fbo;
+    GLuint          polar_src_tex;
+    GLuint          polar_fbo;
+    GLuint          polar_tex;
+    GLuint          atten_fbo[2];
+    GLuint          atten_tex[2];
     GLuint          screen_fbo;
     GLuint          screen_tex;
-    GLuint          shader_screen;
-    GLuint          shader_ant;
-    GLuint          shader_wxr;
-    GLuint          shader_test;
-    GLuint          bezel_tex;
-    GLuint          dots_tex;
-    GLuint          crt_mask_tex;
-    
-    gl_quad_t       *bezel_quad;
+    GLuint          overlay_fbo;
+    GLuint          overlay_tex;
+    gl_program_t    shader_screen;
+    gl_program_t    shader_ant;
+    gl_program_t    shader_wxr;
+    gl_program_t    shader_test;
+    gl_program_t    shader_polar;
+    gl_program_t    shader_scan;
+    gl_program_t    shader_atten;
+    gl_program_t    shader_atten_cs;
+    gl_block_t      *params;
+    rds_link_t      links[RDS_PROGRAM_COUNT];
+    bool            shaders_ready;
+    gl_loader_t     *loader;
+    bool            ready;
+    gl_atlas_t      *atlas;
+    int             bezel_img;
+    int             dots_img;
+    int             crt_mask_img;
+    
+    gl_batch_t      *bezel_batch;
+    gl_batch_t      *text_batch;
+    gl_font_t       *font;
     gl_quad_t       *screen_quad;
     gl_quad_t       *src_quad;
+    gl_quad_t       *polar_quad;
+    gl_quad_t       *atten_quad;
+    gl_sector_t     *scan_sector;
     gl_quad_t       *dots_quad;
     gl_quad_t       *wxr_quad;
+    gl_quad_t       *overlay_quad;
     
+    // Whether the screen's buffers, font and quads exist, and when they were last drawn with.
+    bool            screen_alloc;
+    double          screen_used;
+    float           idle_release;
+    
+    rds_overlay_key_t   overlay_key;
+    bool                overlay_valid;
     
-    XPLMAvionicsID  device;
     
-    NVGcontext      *vg;
+    XPLMAvionicsID  device;
     
     XPLMTextureID   wxr_tex_id;
     
@@ -170,24 +327,27 @@ typedef struct rds81_t {
     
     XPLMDataRef     dr_avionics_power;
     
-    XPLMDataRef     dr_mode;
     XPLMDataRef     dr_tilt;
     XPLMDataRef     dr_tilt_antenna;
-    XPLMDataRef     dr_auto_tilt;
-    XPLMDataRef     dr_gain;
     XPLMDataRef     dr_stab;
     
-    XPLMDataRef     dr_gcs;
-    XPLMDataRef     dr_pws;
-    XPLMDataRef     dr_sector_brg;
-    XPLMDataRef     dr_sector_width;
-    XPLMDataRef     dr_antenna_limit;
-    XPLMDataRef     dr_multiscan;
-    XPLMDataRef     dr_vertical;
+    // The radar settings we force are only written when they change, see dr_shadow_t.
+    dr_shadow_t     dr_mode;
+    dr_shadow_t     dr_auto_tilt;
+    dr_shadow_t     dr_gain;
+    dr_shadow_t     dr_gcs;
+    dr_shadow_t     dr_pws;
+    dr_shadow_t     dr_sector_brg;
+    dr_shadow_t     dr_sector_width;
+    dr_shadow_t     dr_antenna_limit;
+    dr_shadow_t     dr_multiscan;
+    dr_shadow_t     dr_vertical;
     
     XPLMDataRef     dr_range_idx;
     XPLMDataRef     dr_range;
         
+    rds81_frame_inputs_t    inputs;
+        
     // UI elements
     knob_t          knobs[KNOB_COUNT];
     button_t        buttons[BUTTON_COUNT];
@@ -201,16 +361,22 @@ typedef struct rds81_t {
     rds81_mode_t    mode;
     rds81_submode_t submode;
     bool            stab;
+    bool            idle;
     double          on_time;
     double          off_time;
     bool            is_warm;
     
     // Antenna tracking
     float           ant_angle;
-    float           ant_angle_last;
     int             ant_dir;
     bool            ant_clear;
     
+    // The part of the scan the antenna has covered since the last sweep pass, see rds81_update().
+    float           sweep_time;
+    float           sweep_start;
+    float           sweep_end;
+    bool            sweep_pending;
+    
     // The RDS-81/RDR-2000 only let the pilot change the gain in MAP mode, so we need to keep track
     // of it aside from the default XP weather radar's datarefs.
     float           map_gain;
@@ -225,7 +391,7 @@ typedef struct rds81_t {
 extern rds81_out_t wxr_out;
 extern rds81_t *wxr;
 
-GLuint rds81_load_tex(const char *name);
+int rds81_load_image(const char *name);
 
 void rds81_init_kn_butt(rds81_t *wxr);
 void rds81_fini_kn_butt(rds81_t *wxr);
@@ -237,9 +403,22 @@ bool rds81_click_release(rds81_t *wxr);
 bool rds81_scroll(rds81_t *wxr, vec2 pos, int clicks);
 bool rds81_cursor(rds81_t *wxr, vec2 pos);
 
+// The screen's GPU passes, in the order rds_draw_screen() runs them. rds-81_bench.c also times
+// them one by one.
+void rds81_alloc_screen(rds81_t *wxr);
+void rds81_update_params(rds81_t *wxr);
+void rds81_pass_polar(GLuint src_tex, float start, float end, mat4 ortho);
+GLuint rds81_update_atten(float start, float end, mat4 ortho);
+void rds81_pass_sweep(gl_program_t *shader, GLuint atten_tex, float start, float end, mat4 ortho);
+void rds81_pass_scan(float start, float end);
+void rds81_update_overlay(rds81_t *wxr);
+void rds81_pass_copy(mat4 pvm);
+void rds81_pass_screen(mat4 pvm);
+
 void rds81_reset_datarefs(rds81_t *wxr);
+void rds81_read_inputs(rds81_t *wxr);
 void rds81_update(rds81_t *wxr);
-bool rds81_has_power(rds81_t *wxr);
+bool rds81_has_power(const rds81_t *wxr);
 
 #endif /* ifndef _RDS_81_IMPL_H_ */
 
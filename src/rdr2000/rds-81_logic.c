@@ -8,6 +8,7 @@
  *===--------------------------------------------------------------------------------------------===
 */
 #include "rds-81_impl.h"
+#include <XPLMProcessing.h>
 
 rds81_out_t wxr_out;
 
@@ -22,49 +23,83 @@ rds81_side_t rds81_find_best_side() {
 }
 
 
+void rds81_read_inputs(rds81_t *wxr) {
+    rds81_frame_inputs_t *in = &wxr->inputs;
+    int cycle = XPLMGetCycleNumber();
+    if(in->valid && in->cycle == cycle)
+        return;
+    in->valid = true;
+    in->cycle = cycle;
+    
+    float bus_ratio = XPLMGetAvionicsBusVoltsRatio(wxr->device);
+    in->has_power = bus_ratio < 0.f || (XPLMGetDatai(wxr->dr_avionics_power) && bus_ratio > 0.8f);
+    // Only the screen needs these, and it draws nothing while idle.
+    if(wxr->mode != RDS81_MODE_OFF && in->has_power) {
+        in->stab = XPLMGetDatai(wxr->dr_stab);
+        in->range = XPLMGetDataf(wxr->dr_range);
+        in->tilt = XPLMGetDataf(wxr->dr_tilt);
+    }
+    
+    for(int i = 0; i < KNOB_COUNT; ++i) {
+        const knob_t *knob = &wxr->knobs[i];
+        in->knobs[i] = knob->desc->type == KNOB_INT ?
+            XPLMGetDatai(knob->val) : XPLMGetDataf(knob->val);
+    }
+}
+
 void rds81_update(rds81_t *wxr) {
+    // Off or unpowered, the radar is put to rest once, when it goes idle. After that, only the
+    // warm-up clock needs to keep up, and the datarefs are left alone until it comes back on.
+    bool idle = wxr->mode == RDS81_MODE_OFF || !rds81_has_power(wxr);
+    if(idle && wxr->idle) {
+        wxr->on_time = time_get_clock();
+        return;
+    }
+    wxr->idle = idle;
+    
     // Hard-set some of the weather radar datarefs so we don't end up in weird, non realistic
     // situations
-    XPLMSetDataf(wxr->dr_sector_brg, 0);
-    XPLMSetDatai(wxr->dr_auto_tilt, 0);
-    XPLMSetDatai(wxr->dr_gcs, 0);
-    XPLMSetDatai(wxr->dr_pws, 0);
-    XPLMSetDatai(wxr->dr_multiscan, 0);
-    XPLMSetDatai(wxr->dr_vertical, 0);
+    dr_shadow_set_f(&wxr->dr_sector_brg, 0);
+    dr_shadow_set_i(&wxr->dr_auto_tilt, 0);
+    dr_shadow_set_i(&wxr->dr_gcs, 0);
+    dr_shadow_set_i(&wxr->dr_pws, 0);
+    dr_shadow_set_i(&wxr->dr_multiscan, 0);
+    dr_shadow_set_i(&wxr->dr_vertical, 0);
 
     // This is more than we actually display, but lets us do some fuzzing of the data
     // in the antenna shader (mostly: we can simulate smearing at long ranges).
-    XPLMSetDataf(wxr->dr_sector_width, RDS_ANT_LIM + 10);
-    XPLMSetDataf(wxr->dr_antenna_limit, RDS_ANT_LIM + 10);
+    dr_shadow_set_f(&wxr->dr_sector_width, RDS_ANT_LIM + 10);
+    dr_shadow_set_f(&wxr->dr_antenna_limit, RDS_ANT_LIM + 10);
     
     // The RDS-81 only uses the pilot-set gain when it's in GND MAP mode. So outside that mode,
     // we just set it to 1.f (which is the "use calibrated gain" value for XP WXR).
     if(wxr->mode == RDS81_MODE_ON && wxr->submode == RDS81_SUBMODE_MAP) {
         wxr->eff_gain = wxr->map_gain * 2.f;
-        XPLMSetDataf(wxr->dr_gain, wxr->map_gain * 2.f);
+        dr_shadow_set_f(&wxr->dr_gain, wxr->map_gain * 2.f);
     } else {
         wxr->eff_gain = 1.f;
-        XPLMSetDataf(wxr->dr_gain, 1.f);
+        dr_shadow_set_f(&wxr->dr_gain, 1.f);
     }
     
-    // Set the XP WXR's mode to the value that matches our internal mode.
+    // Set the XP WXR's mode to the value that matches our internal mode. Going idle puts it to
+    // rest here, whatever the mode, since this is the last update until the radar comes back on.
     double time_since_on = time_get_clock() - wxr->on_time;
-    if(time_since_on > RDS_WARMUP_ANTENNA) {
+    if(!idle && time_since_on > RDS_WARMUP_ANTENNA) {
         switch(wxr->mode) {
         case RDS81_MODE_OFF:
         case RDS81_MODE_STBY:
-            XPLMSetDatai(wxr->dr_mode, 0);
+            dr_shadow_set_i(&wxr->dr_mode, 0);
             break;
         case RDS81_MODE_TEST:
-            XPLMSetDatai(wxr->dr_mode, 1);
+            dr_shadow_set_i(&wxr->dr_mode, 1);
             break;
         case RDS81_MODE_ON:
-            XPLMSetDatai(wxr->dr_mode, wxr->submode == RDS81_SUBMODE_MAP ? 4 : 2);
+            dr_shadow_set_i(&wxr->dr_mode, wxr->submode == RDS81_SUBMODE_MAP ? 4 : 2);
             break;
         }
         wxr->is_warm = true;
     } else {
-        XPLMSetDatai(wxr->dr_mode, 0);
+        dr_shadow_set_i(&wxr->dr_mode, 0);
         wxr->ant_clear = true;
         wxr->is_warm = false;
     }
@@ -73,31 +108,46 @@ void rds81_update(rds81_t *wxr) {
         wxr->submode = RDS81_SUBMODE_WX;
     }
     
-    // Update the antenna scan
+    // Update the antenna scan. The antenna moves in fixed steps, however long the frame was, and
+    // the angles it covers pile up until the screen runs a sweep pass over them (see
+    // rds_update_wxr_tex()). That way the sweep costs the same at any frame rate.
     if(wxr->mode <= RDS81_MODE_STBY || !rds81_has_power(wxr)) {
         wxr->ant_dir = 1;
         wxr->ant_angle = -45;
         wxr->ant_clear = true;
+        wxr->sweep_time = 0.f;
+        wxr->sweep_pending = false;
     } else {
         const float ant_spd = 45.f/2.f;
-        wxr->ant_angle_last = wxr->ant_angle;
-        float new_angle = wxr->ant_angle + wxr->ant_dir * ant_spd * time_get_dt();
-    
-        if(new_angle > RDS_ANT_LIM) {
-            new_angle = RDS_ANT_LIM;
-            wxr->ant_dir = -1;
-        }
-        if(new_angle < -RDS_ANT_LIM) {
-            new_angle = -RDS_ANT_LIM;
-            wxr->ant_dir = 1;
+        const float step = 1.f / RDS_SWEEP_RATE;
+        wxr->sweep_time = MIN(wxr->sweep_time + time_get_dt(), RDS_SWEEP_MAX_LAG);
+        
+        for(; wxr->sweep_time >= step; wxr->sweep_time -= step) {
+            if(!wxr->sweep_pending) {
+                wxr->sweep_start = wxr->ant_angle;
+                wxr->sweep_end = wxr->ant_angle;
+                wxr->sweep_pending = true;
+            }
+            
+            float new_angle = wxr->ant_angle + wxr->ant_dir * ant_spd * step;
+            if(new_angle > RDS_ANT_LIM) {
+                new_angle = RDS_ANT_LIM;
+                wxr->ant_dir = -1;
+            }
+            if(new_angle < -RDS_ANT_LIM) {
+                new_angle = -RDS_ANT_LIM;
+                wxr->ant_dir = 1;
+            }
+            wxr->ant_angle = new_angle;
+            wxr->sweep_start = MIN(wxr->sweep_start, new_angle);
+            wxr->sweep_end = MAX(wxr->sweep_end, new_angle);
         }
-        wxr->ant_angle = new_angle;
     }
     
     // If we're off, we always reset the "On" time to now, else we set the "off" time. It sounds
     // counter-intuitive, but this means as soon as we're anything but off, the time stops updating,
     // and we have a marker for when the off->on transition happened.
-    if(wxr->mode == RDS81_MODE_OFF || !rds81_has_power(wxr)) {
+    if(wxr->mode == RDS81_MODE_OFF || !rds81_has_power(wxr) || !wxr->ready) {
         wxr->on_time = time_get_clock();
     } else {
         wxr->off_time = time_get_clock();
@@ -105,21 +155,20 @@ void rds81_update(rds81_t *wxr) {
 }
 
 void rds81_reset_datarefs(rds81_t *wxr) {
-    XPLMSetDatai(wxr->dr_mode, 0);
+    dr_shadow_set_i(&wxr->dr_mode, 0);
     XPLMSetDatai(wxr->dr_stab, 1);
     
-    XPLMSetDataf(wxr->dr_sector_brg, 0);
-    XPLMSetDataf(wxr->dr_sector_width, 90);
-    XPLMSetDataf(wxr->dr_antenna_limit, 90);
+    dr_shadow_set_f(&wxr->dr_sector_brg, 0);
+    dr_shadow_set_f(&wxr->dr_sector_width, 90);
+    dr_shadow_set_f(&wxr->dr_antenna_limit, 90);
     
-    XPLMSetDatai(wxr->dr_auto_tilt, 0);
-    XPLMSetDatai(wxr->dr_gcs, 0);
-    XPLMSetDatai(wxr->dr_pws, 0);
-    XPLMSetDatai(wxr->dr_multiscan, 0);
+    dr_shadow_set_i(&wxr->dr_auto_tilt, 0);
+    dr_shadow_set_i(&wxr->dr_gcs, 0);
+    dr_shadow_set_i(&wxr->dr_pws, 0);
+    dr_shadow_set_i(&wxr->dr_multiscan, 0);
 }
 
-bool rds81_has_power(rds81_t *wxr) {
-    float bus_ratio = XPLMGetAvionicsBusVoltsRatio(wxr->device);
-    return bus_ratio < 0.f || XPLMGetDatai(wxr->dr_avionics_power) && bus_ratio > 0.8f;
+bool rds81_has_power(const rds81_t *wxr) {
+    return wxr->inputs.has_power;
 }
 
@@ -0,0 +1,172 @@
+/*===--------------------------------------------------------------------------------------------===
+ * rds-81_perf.c
+ *
+ * Created by Amy Parent <amy@amyparent.com>
+ * Copyright (c) 2024 Laminar Research. All rights reserved
+ *
+ * Licensed under the MIT License
+ *===--------------------------------------------------------------------------------------------===
+*/
+#include "rds-81_impl.h"
+
+#ifdef RDS_PROFILE
+
+// Each stage keeps its last RDS_PERF_SAMPLES timings, in milliseconds. On the GPU, each run of a
+// stage is bracketed by two timestamp queries (which, unlike elapsed time queries, can nest). The
+// results are picked up RDS_PERF_QUERIES runs later, once the GPU has caught up, so reading them
+// never stalls the pipeline. If they're still not in by then, that run isn't timed.
+#define RDS_PERF_SAMPLES    (128)
+#define RDS_PERF_QUERIES    (3)
+
+typedef struct {
+    float       val[RDS_PERF_SAMPLES];
+    unsigned    count;
+    unsigned    next;
+} perf_ring_t;
+
+typedef struct {
+    const char  *name;
+    bool        gpu;
+
+    double      cpu_start;
+    perf_ring_t cpu_ms;
+    perf_ring_t gpu_ms;
+
+    GLuint      queries[RDS_PERF_QUERIES][2];
+    bool        pending[RDS_PERF_QUERIES];
+    unsigned    slot;
+    bool        timing;
+
+    XPLMDataRef dr;
+} perf_stage_t;
+
+static perf_stage_t stages[RDS_PERF_COUNT] = {
+    [RDS_PERF_SCREEN] = {.name = "draw_screen", .gpu = true},
+    [RDS_PERF_BEZEL] = {.name = "draw_bezel", .gpu = true},
+    [RDS_PERF_UPDATE] = {.name = "update", .gpu = false},
+    [RDS_PERF_WXR_TEX] = {.name = "update_wxr_tex", .gpu = true},
+    [RDS_PERF_DRAW_FBO] = {.name = "draw_fbo", .gpu = true},
+};
+
+// Whether the GL context has been checked for timer queries yet, and whether it has them.
+static bool gl_checked = false;
+static bool gl_has_timer = false;
+
+static void ring_push(perf_ring_t *ring, float val) {
+    ring->val[ring->next] = val;
+    ring->next = (ring->next + 1) % RDS_PERF_SAMPLES;
+    ring->count = MIN(ring->count + 1, RDS_PERF_SAMPLES);
+}
+
+static int cmp_float(const void *a, const void *b) {
+    float fa = *(const float *)a, fb = *(const float *)b;
+    return (fa > fb) - (fa < fb);
+}
+
+static void ring_stats(const perf_ring_t *ring, float *avg, float *p99) {
+    *avg = *p99 = 0.f;
+    if(!ring->count)
+        return;
+
+    float sorted[RDS_PERF_SAMPLES];
+    float total = 0.f;
+    for(unsigned i = 0; i < ring->count; ++i) {
+        sorted[i] = ring->val[i];
+        total += ring->val[i];
+    }
+    qsort(sorted, ring->count, sizeof(float), cmp_float);
+    *avg = total / ring->count;
+    *p99 = sorted[(unsigned)ceilf(0.99f * ring->count) - 1];
+}
+
+// Reads back every timestamp pair the GPU is done with.
+static void perf_collect(perf_stage_t *stage) {
+    for(unsigned i = 0; i < RDS_PERF_QUERIES; ++i) {
+        if(!stage->pending[i])
+            continue;
+        GLint available = 0;
+        glGetQueryObjectiv(stage->queries[i][1], GL_QUERY_RESULT_AVAILABLE, &available);
+        if(!available)
+            continue;
+
+        GLuint64 start = 0, end = 0;
+        glGetQueryObjectui64v(stage->queries[i][0], GL_QUERY_RESULT, &start);
+        glGetQueryObjectui64v(stage->queries[i][1], GL_QUERY_RESULT, &end);
+        ring_push(&stage->gpu_ms, (end - start) * 1e-6);
+        stage->pending[i] = false;
+    }
+}
+
+void rds81_perf_begin(rds_perf_stage_t idx) {
+    perf_stage_t *stage = &stages[idx];
+    if(!gl_checked) {
+        gl_has_timer = GLEW_VERSION_3_3 || GLEW_ARB_timer_query;
+        gl_checked = true;
+    }
+
+    stage->timing = false;
+    if(stage->gpu && gl_has_timer) {
+        if(!stage->queries[0][0])
+            glGenQueries(2 * RDS_PERF_QUERIES, &stage->queries[0][0]);
+        perf_collect(stage);
+        if(!stage->pending[stage->slot]) {
+            glQueryCounter(stage->queries[stage->slot][0], GL_TIMESTAMP);
+            stage->timing = true;
+        }
+    }
+    RDS_TRACE_BEGIN(stage->name);
+    stage->cpu_start = time_get_perf();
+}
+
+void rds81_perf_end(rds_perf_stage_t idx) {
+    perf_stage_t *stage = &stages[idx];
+    ring_push(&stage->cpu_ms, 1e3 * (time_get_perf() - stage->cpu_start));
+    RDS_TRACE_END(stage->name);
+
+    if(stage->timing) {
+        glQueryCounter(stage->queries[stage->slot][1], GL_TIMESTAMP);
+        stage->pending[stage->slot] = true;
+        stage->slot = (stage->slot + 1) % RDS_PERF_QUERIES;
+    }
+}
+
+// Each stage's dataref holds its average and 99th percentile CPU time, then the same on the GPU,
+// in milliseconds.
+static int get_perf(void *ptr, float *out, int offset, int max) {
+    const perf_stage_t *stage = ptr;
+    float vals[4];
+    ring_stats(&stage->cpu_ms, &vals[0], &vals[1]);
+    ring_stats(&stage->gpu_ms, &vals[2], &vals[3]);
+
+    if(out == NULL)
+        return 4;
+    int count = CLAMP(4 - offset, 0, max);
+    for(int i = 0; i < count; ++i)
+        out[i] = vals[offset + i];
+    return count;
+}
+
+void rds81_perf_init() {
+    for(int i = 0; i < RDS_PERF_COUNT; ++i) {
+        stages[i].dr = create_dr_vf(get_perf, NULL, &stages[i],
+                                    DR_CMD_PREFIX "rdr2000/perf/%s", stages[i].name);
+    }
+}
+
+void rds81_perf_fini() {
+    for(int i = 0; i < RDS_PERF_COUNT; ++i) {
+        perf_stage_t *stage = &stages[i];
+        XPLMUnregisterDataAccessor(stage->dr);
+        if(stage->queries[0][0])
+            glDeleteQueries(2 * RDS_PERF_QUERIES, &stage->queries[0][0]);
+
+        const char *name = stage->name;
+        bool gpu = stage->gpu;
+        memset(stage, 0, sizeof(*stage));
+        stage->name = name;
+        stage->gpu = gpu;
+    }
+    gl_checked = false;
+}
+
+#endif /* RDS_PROFILE */
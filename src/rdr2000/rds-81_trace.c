@@ -0,0 +1,167 @@
+/*===--------------------------------------------------------------------------------------------===
+ * rds-81_trace.c
+ *
+ * Created by Amy Parent <amy@amyparent.com>
+ * Copyright (c) 2024 Laminar Research. All rights reserved
+ *
+ * Licensed under the MIT License
+ *===--------------------------------------------------------------------------------------------===
+*/
+#include "rds-81_impl.h"
+
+#ifdef RDS_PROFILE
+
+#include <helpers/thread.h>
+#include <stdatomic.h>
+#include <time.h>
+
+// While tracing (see rdr2000/debug/trace_toggle), the sim thread records the begin and end of our
+// callbacks and passes into a ring buffer, without locking, and a writer thread drains it to a
+// Chrome Trace Event file in X-Plane's Output folder, which chrome://tracing and Perfetto open.
+// Only the sim thread records events, and only the name's pointer is kept, so names must be string
+// literals (or __func__). Events that don't fit in the buffer are dropped, and counted.
+
+#define RDS_TRACE_EVENTS    (1 << 16)
+#define RDS_TRACE_FLUSH_MS  (100)
+
+typedef struct {
+    const char  *name;
+    double      ts;
+    char        phase;
+} trace_event_t;
+
+static struct {
+    bool            on;
+    trace_event_t   *events;
+    atomic_uint     head;
+    atomic_uint     tail;
+    atomic_bool     stop;
+    unsigned        dropped;
+
+    FILE            *out;
+    char            *path;
+    bool            first;
+    thread_t        writer;
+
+    XPLMCommandRef  cmd_toggle;
+} trace;
+
+void rds81_trace_event(const char *name, char phase) {
+    if(!trace.on)
+        return;
+    unsigned head = atomic_load_explicit(&trace.head, memory_order_relaxed);
+    unsigned tail = atomic_load_explicit(&trace.tail, memory_order_acquire);
+    if(head - tail >= RDS_TRACE_EVENTS) {
+        trace.dropped += 1;
+        return;
+    }
+
+    trace_event_t *event = &trace.events[head % RDS_TRACE_EVENTS];
+    event->name = name;
+    event->ts = 1e6 * time_get_perf();
+    event->phase = phase;
+    atomic_store_explicit(&trace.head, head + 1, memory_order_release);
+}
+
+// Writes out every event recorded so far. Runs on the writer thread.
+static void trace_flush() {
+    unsigned head = atomic_load_explicit(&trace.head, memory_order_acquire);
+    unsigned tail = atomic_load_explicit(&trace.tail, memory_order_relaxed);
+    for(; tail != head; ++tail) {
+        const trace_event_t *event = &trace.events[tail % RDS_TRACE_EVENTS];
+        fprintf(trace.out, "%s\n{\"name\":\"%s\",\"ph\":\"%c\",\"ts\":%.3f,\"pid\":1,\"tid\":1}",
+                trace.first ? "" : ",", event->name, event->phase, event->ts);
+        trace.first = false;
+    }
+    atomic_store_explicit(&trace.tail, tail, memory_order_release);
+}
+
+static void trace_writer(void *arg) {
+    UNUSED(arg);
+    while(!atomic_load(&trace.stop)) {
+        trace_flush();
+        fflush(trace.out);
+        thread_sleep(RDS_TRACE_FLUSH_MS);
+    }
+    trace_flush();
+}
+
+static void trace_start() {
+    char *dir = fs_make_path(get_xplane_dir(), "Output", "rdr2000", NULL);
+    char name[64];
+    time_t now = time(NULL);
+    strftime(name, sizeof(name), "trace_%Y%m%d_%H%M%S.json", localtime(&now));
+    trace.path = fs_make_path(dir, name, NULL);
+    trace.out = fs_mkdir(dir) ? fopen(trace.path, "w") : NULL;
+    free(dir);
+    if(!trace.out) {
+        log_msg("cannot write trace `%s`", trace.path);
+        free(trace.path);
+        trace.path = NULL;
+        return;
+    }
+
+    // X-Plane's running time when the trace started lines the events up with the sim's own
+    // timings: an event at `ts` happened (ts - trace_start_us) microseconds after it.
+    double start = 1e6 * time_get_perf();
+    fprintf(trace.out, "{\"displayTimeUnit\":\"ms\",\"otherData\":{\"xplane_running_time\":%.6f,"
+            "\"trace_start_us\":%.3f},\"traceEvents\":[\n"
+            "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":1,"
+            "\"args\":{\"name\":\"X-Plane\"}}", time_get_clock(), start);
+
+    trace.events = safe_calloc(RDS_TRACE_EVENTS, sizeof(trace_event_t));
+    atomic_store(&trace.head, 0);
+    atomic_store(&trace.tail, 0);
+    atomic_store(&trace.stop, false);
+    trace.dropped = 0;
+    trace.first = false;
+    if(!thread_create(&trace.writer, trace_writer, NULL)) {
+        log_msg("cannot start the trace writer");
+        fclose(trace.out);
+        free(trace.events);
+        free(trace.path);
+        trace.path = NULL;
+        return;
+    }
+    trace.on = true;
+    log_msg("tracing to `%s`", trace.path);
+}
+
+static void trace_stop() {
+    trace.on = false;
+    atomic_store(&trace.stop, true);
+    thread_join(&trace.writer);
+
+    fprintf(trace.out, "\n]}\n");
+    fclose(trace.out);
+    free(trace.events);
+    log_msg("trace written to `%s` (%u events dropped)", trace.path, trace.dropped);
+    free(trace.path);
+    trace.path = NULL;
+}
+
+static int handle_trace_toggle(XPLMCommandRef cmd, XPLMCommandPhase phase, void *refcon) {
+    UNUSED(cmd);
+    UNUSED(refcon);
+    if(phase != xplm_CommandBegin)
+        return 1;
+    if(trace.on)
+        trace_stop();
+    else
+        trace_start();
+    return 1;
+}
+
+void rds81_trace_init() {
+    trace.cmd_toggle = XPLMCreateCommand(DR_CMD_PREFIX "rdr2000/debug/trace_toggle",
+                                         "RDR2000 start or stop tracing");
+    XPLMRegisterCommandHandler(trace.cmd_toggle, handle_trace_toggle, 1, NULL);
+}
+
+void rds81_trace_fini() {
+    XPLMUnregisterCommandHandler(trace.cmd_toggle, handle_trace_toggle, 1, NULL);
+    if(trace.on)
+        trace_stop();
+}
+
+#endif /* RDS_PROFILE */
@@ -0,0 +1,51 @@
+/*===--------------------------------------------------------------------------------------------===
+ * resources.c
+ *
+ * Created by Amy Parent <amy@amyparent.com>
+ * Copyright (c) 2024 Laminar Research. All rights reserved
+ *
+ * Licensed under the MIT License
+ *===--------------------------------------------------------------------------------------------===
+*/
+#include "resources.h"
+#include "xplane.h"
+#include <helpers/helpers.h>
+
+// Generated at build time, sorted by name.
+extern const resource_t resources[];
+extern const unsigned resource_count;
+
+static bool use_disk = false;
+
+static int cmp_name(const void *key, const void *res) {
+    return strcmp(key, ((const resource_t *)res)->name);
+}
+
+const resource_t *resource_find(const char *name) {
+    ASSERT(name);
+    return bsearch(name, resources, resource_count, sizeof(resource_t), cmp_name);
+}
+
+void resources_set_disk(bool disk) {
+    use_disk = disk;
+}
+
+bool resources_on_disk() {
+    return use_disk;
+}
+
+const char *resource_read(const char *name, char **buffer) {
+    ASSERT(name);
+    ASSERT(buffer);
+    *buffer = NULL;
+    const resource_t *res = resource_find(name);
+    if(res && !use_disk)
+        return (const char *)res->data;
+    
+    char *path = fs_make_path(get_plugin_dir(), "resources", name, NULL);
+    *buffer = fs_read(path, NULL);
+    if(!*buffer)
+        log_msg("cannot read resource `%s`", path);
+    free(path);
+    return *buffer;
+}
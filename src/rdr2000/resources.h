@@ -0,0 +1,39 @@
+/*===--------------------------------------------------------------------------------------------===
+ * resources.h
+ *
+ * Created by Amy Parent <amy@amyparent.com>
+ * Copyright (c) 2024 Laminar Research. All rights reserved
+ *
+ * Licensed under the MIT License
+ *===--------------------------------------------------------------------------------------------===
+*/
+#ifndef _RESOURCES_H_
+#define _RESOURCES_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// The shaders, and the textures texconv makes of the panel's images and font, are built into the
+// plugin (see cmake/embed.cmake), so loading them doesn't touch the disk. Resources are named by
+// their path in the folder, with '/' separators, e.g. "shaders/wxr_copy.vert.420".
+typedef struct {
+    const char      *name;
+    const uint8_t   *data;
+    size_t          size;
+} resource_t;
+
+// Returns the built-in resource `name`, or NULL if there isn't one.
+const resource_t *resource_find(const char *name);
+
+// With disk resources on, the files in the plugin's resources folder are used instead of the
+// built-in ones, so they can be edited and reloaded without rebuilding the plugin.
+void resources_set_disk(bool use_disk);
+bool resources_on_disk(void);
+
+// Returns the contents of resource `name`, NUL-terminated, or NULL if it can't be read. Built-in
+// resources aren't copied, and `buffer` is set to NULL; those read from the resources folder are
+// allocated, and `buffer` is set to what the caller must free once done with them.
+const char *resource_read(const char *name, char **buffer);
+
+#endif /* ifndef _RESOURCES_H_ */
@@ -219,3 +219,17 @@ double time_get_clock(void) {
     return last_update;
 }
 
+double time_get_perf(void) {
+#if	IBM
+    static LARGE_INTEGER freq = {0};
+    if(freq.QuadPart == 0)
+        QueryPerformanceFrequency(&freq);
+    LARGE_INTEGER now;
+    QueryPerformanceCounter(&now);
+    return (double)now.QuadPart / (double)freq.QuadPart;
+#else	/* !IBM */
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+#endif	/* !IBM */
+}
@@ -19,5 +19,8 @@ double time_get_sim_utc(void);
 double time_get_dt(void);
 double time_get_clock(void);
 
+// A monotonic, high-resolution wall clock in seconds, for timing our own code.
+double time_get_perf(void);
+
 #endif /* ifndef _TIME_SYS_H_ */
 
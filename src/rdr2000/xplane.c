@@ -135,6 +135,12 @@ PLUGIN_API void XPluginStop(void) {
 }
 
 PLUGIN_API void XPluginReceiveMessage(XPLMPluginID from, int msg, void *param) {
+#ifdef RDS_PROFILE
+    if(msg == RDS81_MSG_GPU_BENCH) {
+        rds81_gpu_bench(param);
+        return;
+    }
+#endif
     if(msg != XPLM_MSG_PLANE_LOADED)
         return;
     
@@ -242,4 +248,51 @@ XPLMDataRef create_dr_f(XPLMGetDataf_f get, XPLMSetDataf_f set, void *ptr, const
         ptr, ptr);
     register_dre(buf);
     return ref;
-}
\ No newline at end of file
+}
+
+XPLMDataRef create_dr_vf(XPLMGetDatavf_f get, XPLMSetDatavf_f set, void *ptr, const char *fmt, ...) {
+    char buf[1024];
+    va_list args;
+    va_start(args, fmt);
+    vsnprintf(buf, sizeof(buf), fmt, args);
+    va_end(args);
+    
+    XPLMDataRef ref = XPLMRegisterDataAccessor(buf, xplmType_FloatArray, set != NULL,
+        NULL, NULL,
+        NULL, NULL,
+        NULL, NULL,
+        NULL, NULL,
+        get, set,
+        NULL, NULL,
+        ptr, ptr);
+    register_dre(buf);
+    return ref;
+}
+
+void dr_shadow_init(dr_shadow_t *sh, XPLMDataRef dr) {
+    sh->dr = dr;
+    sh->valid = false;
+    sh->val = 0;
+    sh->time = 0;
+}
+
+// Records a write of `val`, returning whether it actually needs to go to X-Plane.
+static bool dr_shadow_update(dr_shadow_t *sh, double val) {
+    double now = time_get_clock();
+    if(sh->valid && sh->val == val && now - sh->time < DR_SHADOW_REASSERT)
+        return false;
+    sh->valid = true;
+    sh->val = val;
+    sh->time = now;
+    return true;
+}
+
+void dr_shadow_set_i(dr_shadow_t *sh, int val) {
+    if(dr_shadow_update(sh, val))
+        XPLMSetDatai(sh->dr, val);
+}
+
+void dr_shadow_set_f(dr_shadow_t *sh, float val) {
+    if(dr_shadow_update(sh, val))
+        XPLMSetDataf(sh->dr, val);
+}
@@ -34,5 +34,22 @@ XPLMCommandRef find_cmd(const char *fmt, ...);
 
 XPLMDataRef create_dr_i(XPLMGetDatai_f get, XPLMSetDatai_f set, void *ptr, const char *fmt, ...);
 XPLMDataRef create_dr_f(XPLMGetDataf_f get, XPLMSetDataf_f set, void *ptr, const char *fmt, ...);
+XPLMDataRef create_dr_vf(XPLMGetDatavf_f get, XPLMSetDatavf_f set, void *ptr, const char *fmt, ...);
+
+// A dataref we write to, along with the last value written, so that writing the same value again
+// doesn't go through to X-Plane. The value is still re-written every DR_SHADOW_REASSERT seconds,
+// in case something else changed it since.
+#define DR_SHADOW_REASSERT  (1.0)
+
+typedef struct {
+    XPLMDataRef dr;
+    bool        valid;
+    double      val;
+    double      time;
+} dr_shadow_t;
+
+void dr_shadow_init(dr_shadow_t *sh, XPLMDataRef dr);
+void dr_shadow_set_i(dr_shadow_t *sh, int val);
+void dr_shadow_set_f(dr_shadow_t *sh, float val);
 
 #endif /* ifndef _XPLANE_H_ */
@@ -0,0 +1,461 @@
+/*===--------------------------------------------------------------------------------------------===
+ * texconv.c
+ *
+ * Created by Amy Parent <amy@amyparent.com>
+ * Copyright (c) 2024 Laminar Research. All rights reserved
+ *
+ * Licensed under the MIT License
+ *===--------------------------------------------------------------------------------------------===
+*/
+#define STB_IMAGE_IMPLEMENTATION
+#include <glutils/pack.h>
+#include <glutils/stb_image.h>
+#include <glutils/texfile.h>
+#include <helpers/helpers.h>
+#include <ft2build.h>
+#include FT_FREETYPE_H
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Converts images to texture files (see texfile.h) at build time, so the plugin doesn't have to
+// decode, pack or mipmap them at load time.
+//
+//  texconv [--atlas WIDTH PADDING] [--font SIZE] [--mips] [--bc] -o OUTPUT INPUT...
+//
+// Without --atlas, there must be a single input. With it, the inputs are packed like the plugin's
+// runtime atlas would, and each is named after its file name. --font bakes the glyphs of a single
+// TrueType input, SIZE pixels high, into an atlas with their metrics (see text.h). --bc compresses
+// the texture to BC1 if it's opaque and BC3 if it isn't. Atlas images then start on a block, and
+// their padding is rounded up to a whole block, so blocks never straddle two images. --mips stops
+// an atlas's mip chain at the last level its padding keeps images from bleeding into each other.
+
+typedef struct {
+    uint8_t     *pixels;
+    unsigned    w, h;
+} level_t;
+
+// The images that go in the texture, before they're packed.
+typedef struct {
+    unsigned        count;
+    pack_img_t      *images;
+    texfile_rect_t  *rects;
+    texfile_glyph_t *glyphs;
+    float           font_size;
+} source_t;
+
+// The overlay only needs digits, capitals and the degree sign, but printable ASCII is cheap.
+static const uint32_t font_chars[][2] = {{0x20, 0x7e}, {0xb0, 0xb0}};
+
+static void usage() {
+    fprintf(stderr, "usage: texconv [--atlas WIDTH PADDING] [--font SIZE] [--mips] [--bc] "
+            "-o OUTPUT INPUT...\n");
+    exit(1);
+}
+
+static const char *base_name(const char *path) {
+    const char *name = path;
+    for(const char *c = path; *c; ++c) {
+        if(*c == '/' || *c == '\\')
+            name = c + 1;
+    }
+    return name;
+}
+
+static bool load_images(source_t *src, char **paths, unsigned count) {
+    src->count = count;
+    src->images = safe_calloc(count, sizeof(*src->images));
+    src->rects = safe_calloc(count, sizeof(*src->rects));
+    for(unsigned i = 0; i < count; ++i) {
+        const char *name = base_name(paths[i]);
+        if(strlen(name) >= TEXFILE_NAME_MAX) {
+            log_msg("image name `%s` is too long", name);
+            return false;
+        }
+        strcpy(src->rects[i].name, name);
+
+        int w = 0, h = 0, components = 0;
+        src->images[i].data = stbi_load(paths[i], &w, &h, &components, 4);
+        if(!src->images[i].data) {
+            log_msg("unable to load image `%s`", paths[i]);
+            return false;
+        }
+        src->images[i].w = w;
+        src->images[i].h = h;
+    }
+    return true;
+}
+
+// Rasterises the glyphs in font_chars as white, premultiplied RGBA images. SIZE is the distance
+// from the font's ascender to its descender, and glyphs aren't hinted, as NanoVG drew them.
+static bool load_font(source_t *src, const char *path, float size) {
+    FT_Library ft = NULL;
+    FT_Face face = NULL;
+    if(FT_Init_FreeType(&ft) || FT_New_Face(ft, path, 0, &face)) {
+        log_msg("unable to load font `%s`", path);
+        if(ft)
+            FT_Done_FreeType(ft);
+        return false;
+    }
+    FT_Size_RequestRec req = {.type = FT_SIZE_REQUEST_TYPE_REAL_DIM, .height = lroundf(size * 64)};
+    if(FT_Request_Size(face, &req)) {
+        log_msg("unable to size font `%s`", path);
+        FT_Done_Face(face);
+        FT_Done_FreeType(ft);
+        return false;
+    }
+
+    unsigned count = 0;
+    for(unsigned i = 0; i < sizeof(font_chars) / sizeof(font_chars[0]); ++i)
+        count += font_chars[i][1] - font_chars[i][0] + 1;
+    src->count = count;
+    src->images = safe_calloc(count, sizeof(*src->images));
+    src->rects = safe_calloc(count, sizeof(*src->rects));
+    src->glyphs = safe_calloc(count, sizeof(*src->glyphs));
+    src->font_size = size;
+
+    unsigned idx = 0;
+    for(unsigned i = 0; i < sizeof(font_chars) / sizeof(font_chars[0]); ++i) {
+        for(uint32_t cp = font_chars[i][0]; cp <= font_chars[i][1]; ++cp, ++idx) {
+            snprintf(src->rects[idx].name, TEXFILE_NAME_MAX, "U+%04X", cp);
+            src->glyphs[idx].codepoint = cp;
+            FT_UInt glyph = FT_Get_Char_Index(face, cp);
+            if(FT_Load_Glyph(face, glyph, FT_LOAD_NO_HINTING | FT_LOAD_RENDER)) {
+                log_msg("unable to render U+%04X", cp);
+                continue;
+            }
+
+            // Blank glyphs (like the space) have no image, and so aren't packed.
+            const FT_GlyphSlot slot = face->glyph;
+            const FT_Bitmap *bitmap = &slot->bitmap;
+            pack_img_t *img = &src->images[idx];
+            if(bitmap->width > 0 && bitmap->rows > 0) {
+                img->w = bitmap->width;
+                img->h = bitmap->rows;
+                img->data = safe_calloc(img->w * img->h, 4);
+                for(unsigned y = 0; y < img->h; ++y) {
+                    const uint8_t *row = bitmap->buffer + y * bitmap->pitch;
+                    for(unsigned x = 0; x < img->w; ++x)
+                        memset(img->data + (y * img->w + x) * 4, row[x], 4);
+                }
+            }
+
+            // The linear advance isn't rounded to whole pixels, in 16.16 fixed point.
+            src->glyphs[idx].advance = slot->linearHoriAdvance / 65536.f;
+            src->glyphs[idx].x_off = slot->bitmap_left;
+            src->glyphs[idx].y_off = -slot->bitmap_top;
+        }
+    }
+    FT_Done_Face(face);
+    FT_Done_FreeType(ft);
+    return true;
+}
+
+// Box-filters `src` down to the next mip level.
+static level_t downsample(const level_t *src) {
+    level_t dst = {.w = MAX(src->w / 2, 1u), .h = MAX(src->h / 2, 1u)};
+    dst.pixels = safe_calloc(dst.w * dst.h, 4);
+    for(unsigned y = 0; y < dst.h; ++y) {
+        unsigned y0 = MIN(y * 2, src->h - 1), y1 = MIN(y * 2 + 1, src->h - 1);
+        for(unsigned x = 0; x < dst.w; ++x) {
+            unsigned x0 = MIN(x * 2, src->w - 1), x1 = MIN(x * 2 + 1, src->w - 1);
+            for(unsigned c = 0; c < 4; ++c) {
+                unsigned sum = src->pixels[(y0 * src->w + x0) * 4 + c]
+                             + src->pixels[(y0 * src->w + x1) * 4 + c]
+                             + src->pixels[(y1 * src->w + x0) * 4 + c]
+                             + src->pixels[(y1 * src->w + x1) * 4 + c];
+                dst.pixels[(y * dst.w + x) * 4 + c] = (sum + 2) / 4;
+            }
+        }
+    }
+    return dst;
+}
+
+static bool is_opaque(const level_t *level) {
+    for(unsigned i = 0; i < level->w * level->h; ++i) {
+        if(level->pixels[i * 4 + 3] != 255)
+            return false;
+    }
+    return true;
+}
+
+static uint16_t to_565(const int rgb[3]) {
+    return ((rgb[0] * 31 + 127) / 255) << 11 | ((rgb[1] * 63 + 127) / 255) << 5
+        | ((rgb[2] * 31 + 127) / 255);
+}
+
+static void from_565(uint16_t c, int rgb[3]) {
+    unsigned r = (c >> 11) & 0x1f, g = (c >> 5) & 0x3f, b = c & 0x1f;
+    rgb[0] = (r << 3) | (r >> 2);
+    rgb[1] = (g << 2) | (g >> 4);
+    rgb[2] = (b << 3) | (b >> 2);
+}
+
+// Picks the block's endpoints along the diagonal of its colours' bounding box that follows how the
+// colours vary (which works well enough for the panel's mostly smooth images), then the closest
+// of the four palette colours for each pixel.
+static void encode_color(uint8_t block[16][4], uint8_t *out) {
+    int lo[3] = {255, 255, 255}, hi[3] = {0, 0, 0}, mean[3] = {0, 0, 0};
+    for(int i = 0; i < 16; ++i) {
+        for(int c = 0; c < 3; ++c) {
+            lo[c] = MIN(lo[c], block[i][c]);
+            hi[c] = MAX(hi[c], block[i][c]);
+            mean[c] += block[i][c];
+        }
+    }
+
+    // Flip the green and blue axes if they go against red (or green, if red doesn't vary).
+    int ref = hi[0] - lo[0] >= hi[1] - lo[1] ? 0 : 1;
+    for(int c = ref + 1; c < 3; ++c) {
+        int cov = 0;
+        for(int i = 0; i < 16; ++i)
+            cov += (block[i][ref] * 16 - mean[ref]) * (block[i][c] * 16 - mean[c]);
+        if(cov < 0) {
+            int tmp = lo[c];
+            lo[c] = hi[c];
+            hi[c] = tmp;
+        }
+    }
+
+    // Inset the box a little, the extremes are rarely worth an endpoint.
+    for(int c = 0; c < 3; ++c) {
+        int inset = (hi[c] - lo[c]) / 16;
+        hi[c] -= inset;
+        lo[c] += inset;
+    }
+
+    // BC1 needs the first endpoint to be the larger one for four colours.
+    uint16_t c0 = to_565(hi), c1 = to_565(lo);
+    if(c0 < c1) {
+        uint16_t tmp = c0;
+        c0 = c1;
+        c1 = tmp;
+    }
+
+    int palette[4][3];
+    from_565(c0, palette[0]);
+    from_565(c1, palette[1]);
+    for(int c = 0; c < 3; ++c) {
+        palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+        palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+    }
+
+    out[0] = c0 & 0xff;
+    out[1] = c0 >> 8;
+    out[2] = c1 & 0xff;
+    out[3] = c1 >> 8;
+    memset(out + 4, 0, 4);
+    // Equal endpoints leave every index at 0, which works in either mode.
+    for(int i = 0; i < 16 && c0 != c1; ++i) {
+        int best = 0, best_dist = INT32_MAX;
+        for(int j = 0; j < 4; ++j) {
+            int dist = 0;
+            for(int c = 0; c < 3; ++c)
+                dist += (block[i][c] - palette[j][c]) * (block[i][c] - palette[j][c]);
+            if(dist < best_dist) {
+                best = j;
+                best_dist = dist;
+            }
+        }
+        out[4 + i / 4] |= best << ((i % 4) * 2);
+    }
+}
+
+static void encode_alpha(uint8_t block[16][4], uint8_t *out) {
+    int a0 = 0, a1 = 255;
+    for(int i = 0; i < 16; ++i) {
+        a0 = MAX(a0, block[i][3]);
+        a1 = MIN(a1, block[i][3]);
+    }
+
+    int palette[8] = {a0, a1};
+    for(int i = 2; i < 8; ++i)
+        palette[i] = ((8 - i) * a0 + (i - 1) * a1) / 7;
+
+    uint64_t bits = 0;
+    for(int i = 0; i < 16 && a0 != a1; ++i) {
+        int best = 0;
+        for(int j = 1; j < 8; ++j) {
+            if(abs(block[i][3] - palette[j]) < abs(block[i][3] - palette[best]))
+                best = j;
+        }
+        bits |= (uint64_t)best << (3 * i);
+    }
+
+    out[0] = a0;
+    out[1] = a1;
+    for(int i = 0; i < 6; ++i)
+        out[2 + i] = bits >> (8 * i);
+}
+
+static uint8_t *encode_level(const level_t *level, texfile_format_t format, size_t *size) {
+    *size = texfile_level_size(format, level->w, level->h);
+    uint8_t *data = safe_calloc(*size, 1);
+    uint8_t *out = data;
+
+    for(unsigned by = 0; by < level->h; by += 4) {
+        for(unsigned bx = 0; bx < level->w; bx += 4) {
+            // Blocks that hang over the edge repeat its pixels.
+            uint8_t block[16][4];
+            for(unsigned i = 0; i < 16; ++i) {
+                unsigned x = MIN(bx + i % 4, level->w - 1);
+                unsigned y = MIN(by + i / 4, level->h - 1);
+                memcpy(block[i], level->pixels + (y * level->w + x) * 4, 4);
+            }
+
+            if(format == TEXFILE_BC3) {
+                encode_alpha(block, out);
+                out += 8;
+            }
+            encode_color(block, out);
+            out += 8;
+        }
+    }
+    return data;
+}
+
+static bool write_zero(FILE *out, size_t size) {
+    static const uint8_t zero[TEXFILE_ALIGN] = {0};
+    size_t pad = texfile_align(size) - size;
+    return fwrite(zero, 1, pad, out) == pad;
+}
+
+static bool write_file(const char *path, texfile_format_t format, const source_t *src,
+                       const level_t *levels, unsigned level_count) {
+    FILE *out = fopen(path, "wb");
+    if(!out) {
+        log_msg("unable to open `%s`", path);
+        return false;
+    }
+
+    texfile_header_t header = {
+        .magic = TEXFILE_MAGIC,
+        .version = TEXFILE_VERSION,
+        .format = format,
+        .width = levels[0].w,
+        .height = levels[0].h,
+        .levels = level_count,
+        .rect_count = src->count,
+        .glyph_count = src->glyphs ? src->count : 0,
+        .font_size = src->font_size,
+    };
+    bool ok = fwrite(&header, sizeof(header), 1, out) == 1;
+    ok = ok && fwrite(src->rects, sizeof(*src->rects), src->count, out) == src->count;
+    ok = ok && write_zero(out, src->count * sizeof(*src->rects));
+    if(src->glyphs) {
+        ok = ok && fwrite(src->glyphs, sizeof(*src->glyphs), src->count, out) == src->count;
+        ok = ok && write_zero(out, src->count * sizeof(*src->glyphs));
+    }
+
+    for(unsigned i = 0; ok && i < level_count; ++i) {
+        size_t size = levels[i].w * levels[i].h * 4;
+        const uint8_t *data = levels[i].pixels;
+        uint8_t *encoded = NULL;
+        if(format != TEXFILE_RGBA8)
+            data = encoded = encode_level(&levels[i], format, &size);
+
+        texfile_level_t level = {.size = size};
+        ok = fwrite(&level, sizeof(level), 1, out) == 1;
+        ok = ok && fwrite(data, 1, size, out) == size;
+        ok = ok && write_zero(out, size);
+        free(encoded);
+    }
+
+    ok = fclose(out) == 0 && ok;
+    if(!ok)
+        log_msg("unable to write `%s`", path);
+    return ok;
+}
+
+int main(int argc, char **argv) {
+    log_init("texconv", NULL);
+
+    const char *output = NULL;
+    bool atlas = false, mips = false, bc = false;
+    unsigned width = 0, padding = 0;
+    float font_size = 0.f;
+    int first = 1;
+    for(; first < argc && argv[first][0] == '-'; ++first) {
+        if(!strcmp(argv[first], "--atlas") && first + 2 < argc) {
+            atlas = true;
+            width = strtoul(argv[++first], NULL, 10);
+            padding = strtoul(argv[++first], NULL, 10);
+        } else if(!strcmp(argv[first], "--font") && first + 1 < argc) {
+            font_size = strtof(argv[++first], NULL);
+        } else if(!strcmp(argv[first], "--mips")) {
+            mips = true;
+        } else if(!strcmp(argv[first], "--bc")) {
+            bc = true;
+        } else if(!strcmp(argv[first], "-o") && first + 1 < argc) {
+            output = argv[++first];
+        } else {
+            usage();
+        }
+    }
+    unsigned count = argc - first;
+    bool font = font_size > 0.f;
+    if(!output || !count || ((!atlas || font) && count != 1) || (atlas && !width))
+        usage();
+
+    // Fonts are always packed, by default in a small atlas. The overlay draws them at half size,
+    // so their padding keeps the first mip level clean too.
+    if(font && !atlas) {
+        atlas = true;
+        width = 256;
+        padding = 4;
+    }
+
+    source_t src = {0};
+    if(font ? !load_font(&src, argv[first], font_size) : !load_images(&src, argv + first, count))
+        return 1;
+
+    level_t levels[TEXFILE_MAX_LEVELS];
+    unsigned level_count = 1;
+    if(atlas) {
+        unsigned align = bc ? 4 : 1;
+        padding = (padding + align - 1) / align * align;
+        unsigned height = pack_images(src.images, src.count, &width, padding, align);
+        levels[0] = (level_t){.pixels = safe_calloc(width * height, 4), .w = width, .h = height};
+        for(unsigned i = 0; i < src.count; ++i) {
+            pack_img_t *img = &src.images[i];
+            if(!img->data)
+                continue;
+            pack_blit(levels[0].pixels, width, img, padding);
+            src.rects[i].x = img->x;
+            src.rects[i].y = img->y;
+            src.rects[i].w = img->w;
+            src.rects[i].h = img->h;
+            free(img->data);
+        }
+    } else {
+        pack_img_t *img = &src.images[0];
+        levels[0] = (level_t){.pixels = img->data, .w = img->w, .h = img->h};
+        src.rects[0].w = img->w;
+        src.rects[0].h = img->h;
+    }
+
+    // Sampling level N with a linear filter reads 2^(N+1) - 1 pixels past an image's edge in the
+    // base level. Atlas levels stop before that reaches past the padding, into the neighbours.
+    unsigned max_levels = TEXFILE_MAX_LEVELS;
+    if(atlas) {
+        max_levels = 1;
+        while(max_levels < TEXFILE_MAX_LEVELS && (2u << max_levels) <= padding + 1)
+            max_levels += 1;
+    }
+    while(mips && level_count < max_levels
+          && (levels[level_count - 1].w > 1 || levels[level_count - 1].h > 1)) {
+        levels[level_count] = downsample(&levels[level_count - 1]);
+        level_count += 1;
+    }
+
+    texfile_format_t format = TEXFILE_RGBA8;
+    if(bc)
+        format = is_opaque(&levels[0]) ? TEXFILE_BC1 : TEXFILE_BC3;
+    bool ok = write_file(output, format, &src, levels, level_count);
+    for(unsigned i = 0; i < level_count; ++i)
+        free(levels[i].pixels);
+    free(src.images);
+    free(src.rects);
+    free(src.glyphs);
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,90 @@
+/*===--------------------------------------------------------------------------------------------===
+ * gpu_bench.c
+ *
+ * Created by Amy Parent <amy@amyparent.com>
+ * Copyright (c) 2024 Laminar Research. All rights reserved
+ *
+ * Licensed under the MIT License
+ *===--------------------------------------------------------------------------------------------===
+*/
+#define GL_GLEXT_PROTOTYPES
+#include "xphost.h"
+#include <helpers/helpers.h>
+#include <rds-81.h>
+#include <GL/gl.h>
+#include <XPLMDataAccess.h>
+#include <XPLMPlugin.h>
+#include <unistd.h>
+
+// Times each of the radar's GPU passes on its own, and writes the results as JSON, so they can be
+// compared from one commit to the next. The plugin is loaded like xphost does, and run until its
+// resources are in, then asked to run the passes (see rds-81_bench.c).
+//
+//  rdr2000_gpu_bench [-n ITERATIONS] [-x DIR] [-o OUTPUT] PLUGIN
+//
+// Each pass is timed ITERATIONS times (100 by default). The results go to OUTPUT, or stdout.
+
+// How long, in frames, the plugin gets to load its resources and link its programs.
+#define BENCH_MAX_FRAMES    (600)
+#define BENCH_RATE          (60.f)
+
+static void usage() {
+    fprintf(stderr, "usage: rdr2000_gpu_bench [-n ITERATIONS] [-x DIR] [-o OUTPUT] PLUGIN\n");
+    exit(1);
+}
+
+int main(int argc, char **argv) {
+    unsigned iterations = 100;
+    const char *xplane_dir = ".";
+    const char *output = NULL;
+
+    int opt;
+    while((opt = getopt(argc, argv, "n:x:o:")) != -1) {
+        switch(opt) {
+        case 'n': iterations = strtoul(optarg, NULL, 10); break;
+        case 'x': xplane_dir = optarg; break;
+        case 'o': output = optarg; break;
+        default: usage(); break;
+        }
+    }
+    if(optind != argc - 1 || iterations == 0)
+        usage();
+    const char *path = argv[optind];
+
+    log_init("rdr2000_gpu_bench", host_log);
+    if(!host_context_init())
+        return 1;
+
+    char *output_dir = fs_make_path(xplane_dir, "Output", NULL);
+    fs_mkdir(output_dir);
+    free(output_dir);
+
+    host_init(path, xplane_dir);
+    GLuint radar_tex = host_radar_tex_new();
+    host_set_radar_tex(radar_tex);
+    host_set_bus_ratio(1.f);
+
+    host_plugin_t plugin;
+    if(!host_plugin_load(&plugin, path) || !host_plugin_start(&plugin, path))
+        return 1;
+
+    // The radar is turned on, so that it draws once with everything it needs.
+    XPLMDataRef dr_mode = XPLMFindDataRef("rdr2000/mode");
+    rds81_bench_t bench = {.iterations = iterations, .path = output};
+    for(unsigned i = 0; i < BENCH_MAX_FRAMES && bench.status == RDS81_BENCH_NOT_READY; ++i) {
+        host_frame(1.f / BENCH_RATE);
+        if(i == 0)
+            XPLMSetDatai(dr_mode, 3);
+        host_draw(false);
+        plugin.message(XPLM_PLUGIN_XPLANE, RDS81_MSG_GPU_BENCH, &bench);
+    }
+    if(bench.status == RDS81_BENCH_NOT_READY)
+        log_msg("the radar wasn't ready after %u frames (is the plugin a profiling build?)",
+                BENCH_MAX_FRAMES);
+
+    host_plugin_stop(&plugin);
+    glDeleteTextures(1, &radar_tex);
+    host_fini();
+    host_context_fini();
+    return bench.status == RDS81_BENCH_DONE ? 0 : 1;
+}
@@ -0,0 +1,156 @@
+/*===--------------------------------------------------------------------------------------------===
+ * host.c
+ *
+ * Created by Amy Parent <amy@amyparent.com>
+ * Copyright (c) 2024 Laminar Research. All rights reserved
+ *
+ * Licensed under the MIT License
+ *===--------------------------------------------------------------------------------------------===
+*/
+#define GL_GLEXT_PROTOTYPES
+#include "xphost.h"
+#include <helpers/helpers.h>
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#include <GL/gl.h>
+#include <GL/glext.h>
+#include <XPLMPlugin.h>
+#include <dlfcn.h>
+#include <time.h>
+
+// What the host programs have in common: the GL context, loading the plugin, and the weather they
+// feed it.
+
+#define HOST_RADAR_SIZE     (512)
+
+void host_log(const char *msg) {
+    fputs(msg, stderr);
+}
+
+double host_wall_clock() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+// Creates a GL context that doesn't need a window or a display server, so the host runs on build
+// machines. Without a GPU, Mesa falls back to llvmpipe.
+bool host_context_init() {
+    PFNEGLGETPLATFORMDISPLAYEXTPROC get_display =
+        (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+    EGLDisplay dpy = get_display ?
+        get_display(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, NULL) : EGL_NO_DISPLAY;
+    if(dpy == EGL_NO_DISPLAY)
+        dpy = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+
+    EGLint major = 0, minor = 0;
+    if(dpy == EGL_NO_DISPLAY || !eglInitialize(dpy, &major, &minor)) {
+        log_msg("cannot initialise EGL");
+        return false;
+    }
+    eglBindAPI(EGL_OPENGL_API);
+
+    static const EGLint config_attr[] = {EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT, EGL_NONE};
+    EGLConfig config = NULL;
+    EGLint count = 0;
+    eglChooseConfig(dpy, config_attr, &config, 1, &count);
+
+    // X-Plane gives plugins a compatibility context.
+    static const EGLint context_attr[] = {
+        EGL_CONTEXT_MAJOR_VERSION, 4,
+        EGL_CONTEXT_MINOR_VERSION, 5,
+        EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_COMPATIBILITY_PROFILE_BIT,
+        EGL_NONE
+    };
+    EGLContext ctx = eglCreateContext(dpy, count ? config : NULL, EGL_NO_CONTEXT, context_attr);
+    if(ctx == EGL_NO_CONTEXT || !eglMakeCurrent(dpy, EGL_NO_SURFACE, EGL_NO_SURFACE, ctx)) {
+        log_msg("cannot create a GL context");
+        return false;
+    }
+    log_msg("EGL %d.%d, %s on %s", major, minor, glGetString(GL_VERSION), glGetString(GL_RENDERER));
+    return true;
+}
+
+void host_context_fini() {
+    EGLDisplay dpy = eglGetCurrentDisplay();
+    EGLContext ctx = eglGetCurrentContext();
+    eglMakeCurrent(dpy, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+    eglDestroyContext(dpy, ctx);
+    eglTerminate(dpy);
+}
+
+bool host_plugin_load(host_plugin_t *plugin, const char *path) {
+    // The plugin's XPLM symbols resolve to the stand-in, which the host exports.
+    plugin->lib = dlopen(path, RTLD_NOW | RTLD_LOCAL);
+    if(!plugin->lib) {
+        log_msg("cannot load `%s`: %s", path, dlerror());
+        return false;
+    }
+    plugin->start = (plugin_start_f)dlsym(plugin->lib, "XPluginStart");
+    plugin->enable = (plugin_enable_f)dlsym(plugin->lib, "XPluginEnable");
+    plugin->disable = (plugin_disable_f)dlsym(plugin->lib, "XPluginDisable");
+    plugin->stop = (plugin_stop_f)dlsym(plugin->lib, "XPluginStop");
+    plugin->message = (plugin_message_f)dlsym(plugin->lib, "XPluginReceiveMessage");
+    if(!plugin->start || !plugin->enable || !plugin->disable || !plugin->stop || !plugin->message) {
+        log_msg("`%s` is not an X-Plane plugin", path);
+        dlclose(plugin->lib);
+        return false;
+    }
+    return true;
+}
+
+bool host_plugin_start(host_plugin_t *plugin, const char *path) {
+    char name[256], sig[256], desc[256];
+    double start = host_wall_clock();
+    if(!plugin->start(name, sig, desc) || !plugin->enable()) {
+        log_msg("`%s` failed to start", path);
+        return false;
+    }
+    plugin->message(XPLM_PLUGIN_XPLANE, XPLM_MSG_PLANE_LOADED, (void *)0);
+    log_msg("started %s (%s) in %.1fms", name, sig, 1e3 * (host_wall_clock() - start));
+    return true;
+}
+
+void host_plugin_stop(host_plugin_t *plugin) {
+    plugin->disable();
+    plugin->stop();
+    dlclose(plugin->lib);
+}
+
+// A few storm cells of different strengths in front of the aircraft, in the radar texture's red
+// channel. The aircraft is at the middle of the bottom edge.
+unsigned host_radar_tex_new() {
+    static const float cells[][4] = {
+        // x, y, radius, strength
+        {0.50f, 0.45f, 0.08f, 1.00f},
+        {0.30f, 0.30f, 0.05f, 0.60f},
+        {0.72f, 0.62f, 0.12f, 0.80f},
+        {0.60f, 0.20f, 0.03f, 0.40f},
+    };
+    const unsigned size = HOST_RADAR_SIZE;
+    uint8_t *pixels = safe_calloc(size * size, 4);
+    for(unsigned y = 0; y < size; ++y) {
+        for(unsigned x = 0; x < size; ++x) {
+            float u = (x + 0.5f) / size, v = (y + 0.5f) / size;
+            float val = 0.f;
+            for(unsigned i = 0; i < sizeof(cells) / sizeof(cells[0]); ++i) {
+                float dx = (u - cells[i][0]) / cells[i][2], dy = (v - cells[i][1]) / cells[i][2];
+                val += cells[i][3] * expf(-(dx * dx + dy * dy));
+            }
+            pixels[(y * size + x) * 4] = (uint8_t)(255.f * MIN(val, 1.f));
+            pixels[(y * size + x) * 4 + 3] = 255;
+        }
+    }
+
+    GLuint tex = 0;
+    glGenTextures(1, &tex);
+    glBindTexture(GL_TEXTURE_2D, tex);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, size, size, 0, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    free(pixels);
+    return tex;
+}
@@ -0,0 +1,128 @@
+/*===--------------------------------------------------------------------------------------------===
+ * xphost.c
+ *
+ * Created by Amy Parent <amy@amyparent.com>
+ * Copyright (c) 2024 Laminar Research. All rights reserved
+ *
+ * Licensed under the MIT License
+ *===--------------------------------------------------------------------------------------------===
+*/
+#define GL_GLEXT_PROTOTYPES
+#include "xphost.h"
+#include <helpers/helpers.h>
+#include <GL/gl.h>
+#include <GL/glext.h>
+#include <XPLMDataAccess.h>
+#include <unistd.h>
+
+// Runs the plugin without X-Plane, on a headless GL context: it loads the plugin, drives its
+// flight loops and avionics callbacks for a number of simulated frames, and reports how long they
+// took. The radar is fed a made-up weather texture, so the whole screen pipeline runs.
+//
+//  xphost [-n FRAMES] [-r RATE] [-m MODE] [-b] [-u] [-x DIR] [-o OUTPUT] PLUGIN
+//
+// Frames are RATE Hz apart in simulator time (60 by default), however long they take to draw. MODE
+// is what rdr2000/mode is set to once the radar exists (3, on, by default). -b draws the bezel too,
+// like an open popup, and -u cuts the avionics bus. DIR stands in for X-Plane's folder, where the
+// shader cache goes. -o saves the last screen drawn to a PPM image.
+
+static void usage() {
+    fprintf(stderr, "usage: xphost [-n FRAMES] [-r RATE] [-m MODE] [-b] [-u] [-x DIR] [-o OUTPUT] "
+            "PLUGIN\n");
+    exit(1);
+}
+
+static bool save_screen(const char *path) {
+    unsigned w = 0, h = 0;
+    uint8_t *pixels = host_read_screen(0, &w, &h);
+    if(!pixels) {
+        log_msg("the plugin didn't create an avionics device");
+        return false;
+    }
+    FILE *f = fopen(path, "wb");
+    if(!f) {
+        log_msg("cannot write `%s`", path);
+        free(pixels);
+        return false;
+    }
+    fprintf(f, "P6\n%u %u\n255\n", w, h);
+    for(unsigned y = h; y-- > 0;) {
+        for(unsigned x = 0; x < w; ++x)
+            fwrite(pixels + (y * w + x) * 4, 1, 3, f);
+    }
+    fclose(f);
+    free(pixels);
+    return true;
+}
+
+int main(int argc, char **argv) {
+    unsigned frames = 900;
+    float rate = 60.f;
+    int mode = 3;
+    bool bezel = false;
+    bool unpowered = false;
+    const char *xplane_dir = ".";
+    const char *output = NULL;
+
+    int opt;
+    while((opt = getopt(argc, argv, "n:r:m:bux:o:")) != -1) {
+        switch(opt) {
+        case 'n': frames = strtoul(optarg, NULL, 10); break;
+        case 'r': rate = strtof(optarg, NULL); break;
+        case 'm': mode = atoi(optarg); break;
+        case 'b': bezel = true; break;
+        case 'u': unpowered = true; break;
+        case 'x': xplane_dir = optarg; break;
+        case 'o': output = optarg; break;
+        default: usage(); break;
+        }
+    }
+    if(optind != argc - 1 || rate <= 0.f)
+        usage();
+    const char *path = argv[optind];
+
+    log_init("xphost", host_log);
+    if(!host_context_init())
+        return 1;
+
+    // X-Plane makes its folder's Output directory, the plugin only makes its cache folder in it.
+    char *output_dir = fs_make_path(xplane_dir, "Output", NULL);
+    fs_mkdir(output_dir);
+    free(output_dir);
+
+    host_init(path, xplane_dir);
+    GLuint radar_tex = host_radar_tex_new();
+    host_set_radar_tex(radar_tex);
+    host_set_bus_ratio(unpowered ? 0.f : 1.f);
+
+    host_plugin_t plugin;
+    if(!host_plugin_load(&plugin, path) || !host_plugin_start(&plugin, path))
+        return 1;
+
+    // The radar only exists once the plugin's first flight loop has run.
+    XPLMDataRef dr_mode = XPLMFindDataRef("rdr2000/mode");
+    double frames_start = host_wall_clock();
+    for(unsigned i = 0; i < frames; ++i) {
+        host_frame(1.f / rate);
+        if(i == 0)
+            XPLMSetDatai(dr_mode, mode);
+        host_draw(bezel);
+    }
+    glFinish();
+    double elapsed = host_wall_clock() - frames_start;
+    log_msg("%u frames (%.1fs simulated) in %.1fms, %.3fms per frame", frames, frames / rate,
+            1e3 * elapsed, frames ? 1e3 * elapsed / frames : 0.0);
+
+    bool ok = host_device_count() > 0;
+    if(!ok)
+        log_msg("the plugin didn't create an avionics device");
+    if(ok && output)
+        ok = save_screen(output);
+
+    host_plugin_stop(&plugin);
+
+    glDeleteTextures(1, &radar_tex);
+    host_fini();
+    host_context_fini();
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,79 @@
+/*===--------------------------------------------------------------------------------------------===
+ * xphost.h
+ *
+ * Created by Amy Parent <amy@amyparent.com>
+ * Copyright (c) 2024 Laminar Research. All rights reserved
+ *
+ * Licensed under the MIT License
+ *===--------------------------------------------------------------------------------------------===
+*/
+#ifndef _XPHOST_H_
+#define _XPHOST_H_
+
+#include <XPLMDefs.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+// The host side of the XPLM stand-in (see xplm.c). The host drives the simulator's loop through
+// these, and the plugin sees the XPLM API it would inside X-Plane, backed by in-memory datarefs.
+
+// Sets up the stand-in. `plugin_path` is what XPLMGetPluginInfo() reports for the plugin, and
+// `xplane_dir` is X-Plane's folder (XPLMGetSystemPath()). A GL context must be current.
+void host_init(const char *plugin_path, const char *xplane_dir);
+void host_fini(void);
+
+// Sets the GL texture returned for X-Plane's weather radar textures.
+void host_set_radar_tex(unsigned tex);
+// Sets the ratio returned by XPLMGetAvionicsBusVoltsRatio().
+void host_set_bus_ratio(float ratio);
+
+// Moves the simulator `dt` seconds forward, and runs the flight loops that are due.
+void host_frame(float dt);
+
+// Draws every avionics device the plugin created into its own framebuffers, as X-Plane would
+// before rendering a frame. The bezels are only drawn when `bezel` is true, like popups.
+void host_draw(bool bezel);
+
+// Returns how many avionics devices the plugin created.
+unsigned host_device_count(void);
+
+// Reads back the last screen drawn for device `idx` as RGBA, bottom row first. Returns NULL if there
+// is no such device. The caller frees the pixels.
+uint8_t *host_read_screen(unsigned idx, unsigned *w, unsigned *h);
+
+// The host programs' side (see host.c).
+
+typedef int (*plugin_start_f)(char *name, char *sig, char *desc);
+typedef int (*plugin_enable_f)(void);
+typedef void (*plugin_disable_f)(void);
+typedef void (*plugin_stop_f)(void);
+typedef void (*plugin_message_f)(XPLMPluginID from, int msg, void *param);
+
+typedef struct {
+    void                *lib;
+    plugin_start_f      start;
+    plugin_enable_f     enable;
+    plugin_disable_f    disable;
+    plugin_stop_f       stop;
+    plugin_message_f    message;
+} host_plugin_t;
+
+// Writes log messages to stderr, see log_init().
+void host_log(const char *msg);
+double host_wall_clock(void);
+
+// Creates a headless GL context and makes it current, or tears it down.
+bool host_context_init(void);
+void host_context_fini(void);
+
+// Loads the plugin at `path` and finds its entry points.
+bool host_plugin_load(host_plugin_t *plugin, const char *path);
+// Starts and enables the plugin, and tells it the user's aircraft loaded.
+bool host_plugin_start(host_plugin_t *plugin, const char *path);
+// Disables, stops and unloads the plugin.
+void host_plugin_stop(host_plugin_t *plugin);
+
+// Returns a new texture with a few storm cells, to stand in for X-Plane's weather radar texture.
+unsigned host_radar_tex_new(void);
+
+#endif /* ifndef _XPHOST_H_ */
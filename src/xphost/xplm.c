@@ -0,0 +1,700 @@
+/*===--------------------------------------------------------------------------------------------===
+ * xplm.c
+ *
+ * Created by Amy Parent <amy@amyparent.com>
+ * Copyright (c) 2024 Laminar Research. All rights reserved
+ *
+ * Licensed under the MIT License
+ *===--------------------------------------------------------------------------------------------===
+*/
+#define GL_GLEXT_PROTOTYPES
+#include "xphost.h"
+#include <helpers/helpers.h>
+#include <GL/gl.h>
+#include <GL/glext.h>
+#include <XPLMDataAccess.h>
+#include <XPLMDisplay.h>
+#include <XPLMGraphics.h>
+#include <XPLMMenus.h>
+#include <XPLMPlanes.h>
+#include <XPLMPlugin.h>
+#include <XPLMProcessing.h>
+#include <XPLMUtilities.h>
+
+// A stand-in for the parts of the XPLM API the plugin uses, so it can run outside of X-Plane. The
+// plugin is loaded in the host's process, and its XPLM calls resolve to the functions below. Any
+// dataref X-Plane would have is created, zeroed, the first time it's looked up.
+
+#define HOST_PLUGIN_ID      (1)
+#define HOST_MAX_VALUES     (16)
+
+typedef struct {
+    char                *name;
+    bool                owned;
+
+    // Datarefs X-Plane owns keep their value here.
+    double              value;
+    int                 ivalues[HOST_MAX_VALUES];
+    float               fvalues[HOST_MAX_VALUES];
+
+    // Datarefs the plugin registered go through its accessors.
+    XPLMDataTypeID      types;
+    XPLMGetDatai_f      get_i;
+    XPLMSetDatai_f      set_i;
+    XPLMGetDataf_f      get_f;
+    XPLMSetDataf_f      set_f;
+    XPLMGetDatad_f      get_d;
+    XPLMSetDatad_f      set_d;
+    XPLMGetDatavi_f     get_vi;
+    XPLMSetDatavi_f     set_vi;
+    XPLMGetDatavf_f     get_vf;
+    XPLMSetDatavf_f     set_vf;
+    void                *read_ref;
+    void                *write_ref;
+} host_dataref_t;
+
+typedef struct {
+    XPLMCommandCallback_f   handler;
+    int                     before;
+    void                    *refcon;
+} host_handler_t;
+
+typedef struct {
+    char            *name;
+    unsigned        count;
+    host_handler_t  handlers[32];
+} host_command_t;
+
+typedef struct {
+    XPLMFlightLoop_f    callback;
+    void                *refcon;
+    float               interval;
+    double              next_time;
+    int                 next_cycle;
+    double              last_time;
+    int                 counter;
+} host_floop_t;
+
+typedef struct {
+    XPLMCreateAvionics_t    desc;
+    float                   rheo;
+    bool                    popup;
+
+    GLuint                  screen_fbo;
+    GLuint                  screen_tex;
+    GLuint                  bezel_fbo;
+    GLuint                  bezel_tex;
+} host_device_t;
+
+static struct {
+    char            plugin_path[512];
+    char            xplane_dir[256];
+
+    double          time;
+    int             cycle;
+    unsigned        radar_tex;
+    float           bus_ratio;
+
+    unsigned        dataref_count;
+    host_dataref_t  *datarefs[512];
+    unsigned        command_count;
+    host_command_t  *commands[128];
+    unsigned        floop_count;
+    host_floop_t    floops[32];
+    unsigned        device_count;
+    host_device_t   *devices[8];
+    int             menu_items;
+
+    host_dataref_t  *dr_time;
+    host_dataref_t  *dr_fbo;
+    host_dataref_t  *dr_viewport;
+    host_dataref_t  *dr_proj;
+    host_dataref_t  *dr_mv;
+} host;
+
+// MARK: - Datarefs
+
+static host_dataref_t *dataref_find(const char *name) {
+    for(unsigned i = 0; i < host.dataref_count; ++i) {
+        if(!strcmp(host.datarefs[i]->name, name))
+            return host.datarefs[i];
+    }
+    return NULL;
+}
+
+static host_dataref_t *dataref_new(const char *name) {
+    ASSERT(host.dataref_count < sizeof(host.datarefs) / sizeof(host.datarefs[0]));
+    host_dataref_t *dr = safe_calloc(1, sizeof(*dr));
+    dr->name = safe_strdup(name);
+    host.datarefs[host.dataref_count++] = dr;
+    return dr;
+}
+
+XPLMDataRef XPLMFindDataRef(const char *name) {
+    host_dataref_t *dr = dataref_find(name);
+    if(dr)
+        return dr;
+    dr = dataref_new(name);
+    dr->owned = true;
+    dr->types = xplmType_Int | xplmType_Float | xplmType_Double | xplmType_IntArray
+        | xplmType_FloatArray;
+    return dr;
+}
+
+XPLMDataRef XPLMRegisterDataAccessor(const char *name, XPLMDataTypeID types, int writable,
+                                     XPLMGetDatai_f get_i, XPLMSetDatai_f set_i,
+                                     XPLMGetDataf_f get_f, XPLMSetDataf_f set_f,
+                                     XPLMGetDatad_f get_d, XPLMSetDatad_f set_d,
+                                     XPLMGetDatavi_f get_vi, XPLMSetDatavi_f set_vi,
+                                     XPLMGetDatavf_f get_vf, XPLMSetDatavf_f set_vf,
+                                     XPLMGetDatab_f get_b, XPLMSetDatab_f set_b,
+                                     void *read_ref, void *write_ref) {
+    UNUSED(get_b);
+    UNUSED(set_b);
+    host_dataref_t *dr = dataref_find(name);
+    if(!dr)
+        dr = dataref_new(name);
+    dr->owned = false;
+    dr->types = types;
+    dr->get_i = get_i;
+    dr->get_f = get_f;
+    dr->get_d = get_d;
+    dr->get_vi = get_vi;
+    dr->get_vf = get_vf;
+    if(writable) {
+        dr->set_i = set_i;
+        dr->set_f = set_f;
+        dr->set_d = set_d;
+        dr->set_vi = set_vi;
+        dr->set_vf = set_vf;
+    }
+    dr->read_ref = read_ref;
+    dr->write_ref = write_ref;
+    return dr;
+}
+
+void XPLMUnregisterDataAccessor(XPLMDataRef ref) {
+    host_dataref_t *dr = ref;
+    if(!dr)
+        return;
+    // The dataref stays findable, like in X-Plane, it just stops answering.
+    dr->types = xplmType_Unknown;
+    dr->get_i = NULL;
+    dr->set_i = NULL;
+    dr->get_f = NULL;
+    dr->set_f = NULL;
+    dr->get_d = NULL;
+    dr->set_d = NULL;
+    dr->get_vi = NULL;
+    dr->set_vi = NULL;
+    dr->get_vf = NULL;
+    dr->set_vf = NULL;
+}
+
+int XPLMGetDatai(XPLMDataRef ref) {
+    host_dataref_t *dr = ref;
+    if(dr->owned)
+        return (int)dr->value;
+    if(dr->get_i)
+        return dr->get_i(dr->read_ref);
+    if(dr->get_f)
+        return (int)dr->get_f(dr->read_ref);
+    return 0;
+}
+
+void XPLMSetDatai(XPLMDataRef ref, int val) {
+    host_dataref_t *dr = ref;
+    if(dr->owned)
+        dr->value = val;
+    else if(dr->set_i)
+        dr->set_i(dr->write_ref, val);
+    else if(dr->set_f)
+        dr->set_f(dr->write_ref, val);
+}
+
+float XPLMGetDataf(XPLMDataRef ref) {
+    host_dataref_t *dr = ref;
+    if(dr->owned)
+        return (float)dr->value;
+    if(dr->get_f)
+        return dr->get_f(dr->read_ref);
+    if(dr->get_i)
+        return dr->get_i(dr->read_ref);
+    return 0.f;
+}
+
+void XPLMSetDataf(XPLMDataRef ref, float val) {
+    host_dataref_t *dr = ref;
+    if(dr->owned)
+        dr->value = val;
+    else if(dr->set_f)
+        dr->set_f(dr->write_ref, val);
+    else if(dr->set_i)
+        dr->set_i(dr->write_ref, (int)val);
+}
+
+double XPLMGetDatad(XPLMDataRef ref) {
+    host_dataref_t *dr = ref;
+    if(dr->owned)
+        return dr->value;
+    if(dr->get_d)
+        return dr->get_d(dr->read_ref);
+    return XPLMGetDataf(ref);
+}
+
+void XPLMSetDatad(XPLMDataRef ref, double val) {
+    host_dataref_t *dr = ref;
+    if(dr->owned)
+        dr->value = val;
+    else if(dr->set_d)
+        dr->set_d(dr->write_ref, val);
+    else
+        XPLMSetDataf(ref, (float)val);
+}
+
+int XPLMGetDatavi(XPLMDataRef ref, int *out, int offset, int max) {
+    host_dataref_t *dr = ref;
+    if(!dr->owned)
+        return dr->get_vi ? dr->get_vi(dr->read_ref, out, offset, max) : 0;
+    if(!out)
+        return HOST_MAX_VALUES;
+    int count = CLAMP(HOST_MAX_VALUES - offset, 0, max);
+    memcpy(out, dr->ivalues + offset, count * sizeof(int));
+    return count;
+}
+
+void XPLMSetDatavi(XPLMDataRef ref, int *values, int offset, int count) {
+    host_dataref_t *dr = ref;
+    if(!dr->owned) {
+        if(dr->set_vi)
+            dr->set_vi(dr->write_ref, values, offset, count);
+        return;
+    }
+    count = CLAMP(HOST_MAX_VALUES - offset, 0, count);
+    memcpy(dr->ivalues + offset, values, count * sizeof(int));
+}
+
+int XPLMGetDatavf(XPLMDataRef ref, float *out, int offset, int max) {
+    host_dataref_t *dr = ref;
+    if(!dr->owned)
+        return dr->get_vf ? dr->get_vf(dr->read_ref, out, offset, max) : 0;
+    if(!out)
+        return HOST_MAX_VALUES;
+    int count = CLAMP(HOST_MAX_VALUES - offset, 0, max);
+    memcpy(out, dr->fvalues + offset, count * sizeof(float));
+    return count;
+}
+
+void XPLMSetDatavf(XPLMDataRef ref, float *values, int offset, int count) {
+    host_dataref_t *dr = ref;
+    if(!dr->owned) {
+        if(dr->set_vf)
+            dr->set_vf(dr->write_ref, values, offset, count);
+        return;
+    }
+    count = CLAMP(HOST_MAX_VALUES - offset, 0, count);
+    memcpy(dr->fvalues + offset, values, count * sizeof(float));
+}
+
+// MARK: - Commands
+
+static host_command_t *command_find(const char *name) {
+    for(unsigned i = 0; i < host.command_count; ++i) {
+        if(!strcmp(host.commands[i]->name, name))
+            return host.commands[i];
+    }
+    return NULL;
+}
+
+XPLMCommandRef XPLMFindCommand(const char *name) {
+    return command_find(name);
+}
+
+XPLMCommandRef XPLMCreateCommand(const char *name, const char *desc) {
+    UNUSED(desc);
+    host_command_t *cmd = command_find(name);
+    if(cmd)
+        return cmd;
+    ASSERT(host.command_count < sizeof(host.commands) / sizeof(host.commands[0]));
+    cmd = safe_calloc(1, sizeof(*cmd));
+    cmd->name = safe_strdup(name);
+    host.commands[host.command_count++] = cmd;
+    return cmd;
+}
+
+void XPLMRegisterCommandHandler(XPLMCommandRef ref, XPLMCommandCallback_f handler, int before,
+                                void *refcon) {
+    host_command_t *cmd = ref;
+    ASSERT(cmd->count < sizeof(cmd->handlers) / sizeof(cmd->handlers[0]));
+    cmd->handlers[cmd->count++] = (host_handler_t){handler, before, refcon};
+}
+
+void XPLMUnregisterCommandHandler(XPLMCommandRef ref, XPLMCommandCallback_f handler, int before,
+                                  void *refcon) {
+    host_command_t *cmd = ref;
+    for(unsigned i = 0; i < cmd->count; ++i) {
+        const host_handler_t *h = &cmd->handlers[i];
+        if(h->handler != handler || h->before != before || h->refcon != refcon)
+            continue;
+        memmove(&cmd->handlers[i], &cmd->handlers[i+1], (cmd->count - i - 1) * sizeof(*h));
+        cmd->count -= 1;
+        return;
+    }
+}
+
+// Handlers that run before X-Plane go first, and any of them can stop the command there.
+static void command_run(host_command_t *cmd, XPLMCommandPhase phase) {
+    for(int before = 1; before >= 0; --before) {
+        for(unsigned i = 0; i < cmd->count; ++i) {
+            const host_handler_t *h = &cmd->handlers[i];
+            if(h->before == before && !h->handler(cmd, phase, h->refcon))
+                return;
+        }
+    }
+}
+
+void XPLMCommandBegin(XPLMCommandRef ref) {
+    command_run(ref, xplm_CommandBegin);
+}
+
+void XPLMCommandEnd(XPLMCommandRef ref) {
+    command_run(ref, xplm_CommandEnd);
+}
+
+void XPLMCommandOnce(XPLMCommandRef ref) {
+    command_run(ref, xplm_CommandBegin);
+    command_run(ref, xplm_CommandEnd);
+}
+
+// MARK: - Processing
+
+// Positive intervals are in seconds, negative ones in frames, and 0 stops the callback.
+static void floop_schedule(host_floop_t *floop, float interval) {
+    floop->interval = interval;
+    floop->next_time = host.time + (interval > 0.f ? interval : 0.f);
+    floop->next_cycle = host.cycle + (interval < 0.f ? (int)-interval : 0);
+}
+
+void XPLMRegisterFlightLoopCallback(XPLMFlightLoop_f callback, float interval, void *refcon) {
+    ASSERT(host.floop_count < sizeof(host.floops) / sizeof(host.floops[0]));
+    host_floop_t *floop = &host.floops[host.floop_count++];
+    *floop = (host_floop_t){.callback = callback, .refcon = refcon, .last_time = host.time};
+    floop_schedule(floop, interval);
+}
+
+void XPLMUnregisterFlightLoopCallback(XPLMFlightLoop_f callback, void *refcon) {
+    for(unsigned i = 0; i < host.floop_count; ++i) {
+        const host_floop_t *floop = &host.floops[i];
+        if(floop->callback != callback || floop->refcon != refcon)
+            continue;
+        memmove(&host.floops[i], &host.floops[i+1], (host.floop_count - i - 1) * sizeof(*floop));
+        host.floop_count -= 1;
+        return;
+    }
+}
+
+int XPLMGetCycleNumber(void) {
+    return host.cycle;
+}
+
+float XPLMGetElapsedTime(void) {
+    return host.time;
+}
+
+// MARK: - Graphics
+
+void XPLMSetGraphicsState(int fog, int tex_units, int lighting, int alpha_test, int blend,
+                          int depth_test, int depth_write) {
+    UNUSED(fog);
+    UNUSED(tex_units);
+    UNUSED(lighting);
+    UNUSED(alpha_test);
+    if(blend) {
+        glEnable(GL_BLEND);
+        glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    } else {
+        glDisable(GL_BLEND);
+    }
+    if(depth_test)
+        glEnable(GL_DEPTH_TEST);
+    else
+        glDisable(GL_DEPTH_TEST);
+    glDepthMask(depth_write ? GL_TRUE : GL_FALSE);
+}
+
+void XPLMBindTexture2d(int tex, int unit) {
+    glActiveTexture(GL_TEXTURE0 + unit);
+    glBindTexture(GL_TEXTURE_2D, tex);
+    glActiveTexture(GL_TEXTURE0);
+}
+
+int XPLMGetTexture(XPLMTextureID id) {
+    if(id == xplm_Tex_Radar_Pilot || id == xplm_Tex_Radar_Copilot)
+        return host.radar_tex;
+    return 0;
+}
+
+// MARK: - Avionics
+
+XPLMAvionicsID XPLMCreateAvionicsEx(XPLMCreateAvionics_t *params) {
+    ASSERT(host.device_count < sizeof(host.devices) / sizeof(host.devices[0]));
+    host_device_t *dev = safe_calloc(1, sizeof(*dev));
+    memcpy(&dev->desc, params, MIN((size_t)params->structSize, sizeof(dev->desc)));
+    dev->rheo = 1.f;
+
+    // Like X-Plane, we own the framebuffers the device draws into.
+    GLuint *fbos[2] = {&dev->screen_fbo, &dev->bezel_fbo};
+    GLuint *texs[2] = {&dev->screen_tex, &dev->bezel_tex};
+    int w[2] = {params->screenWidth, params->bezelWidth};
+    int h[2] = {params->screenHeight, params->bezelHeight};
+    for(int i = 0; i < 2; ++i) {
+        glGenTextures(1, texs[i]);
+        glBindTexture(GL_TEXTURE_2D, *texs[i]);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, w[i], h[i], 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glGenFramebuffers(1, fbos[i]);
+        glBindFramebuffer(GL_FRAMEBUFFER, *fbos[i]);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, *texs[i], 0);
+        ASSERT(glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE);
+    }
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+    host.devices[host.device_count++] = dev;
+    return dev;
+}
+
+void XPLMDestroyAvionics(XPLMAvionicsID id) {
+    for(unsigned i = 0; i < host.device_count; ++i) {
+        host_device_t *dev = host.devices[i];
+        if(dev != id)
+            continue;
+        glDeleteFramebuffers(1, &dev->screen_fbo);
+        glDeleteFramebuffers(1, &dev->bezel_fbo);
+        glDeleteTextures(1, &dev->screen_tex);
+        glDeleteTextures(1, &dev->bezel_tex);
+        free(dev);
+        memmove(&host.devices[i], &host.devices[i+1], (host.device_count - i - 1) * sizeof(dev));
+        host.device_count -= 1;
+        return;
+    }
+}
+
+void XPLMSetAvionicsBrightnessRheo(XPLMAvionicsID id, float rheo) {
+    ((host_device_t *)id)->rheo = rheo;
+}
+
+float XPLMGetAvionicsBrightnessRheo(XPLMAvionicsID id) {
+    return ((host_device_t *)id)->rheo;
+}
+
+float XPLMGetAvionicsBusVoltsRatio(XPLMAvionicsID id) {
+    UNUSED(id);
+    return host.bus_ratio;
+}
+
+void XPLMSetAvionicsPopupVisible(XPLMAvionicsID id, int visible) {
+    ((host_device_t *)id)->popup = visible;
+}
+
+int XPLMIsAvionicsPopupVisible(XPLMAvionicsID id) {
+    return ((host_device_t *)id)->popup;
+}
+
+void XPLMPopOutAvionics(XPLMAvionicsID id) {
+    UNUSED(id);
+}
+
+// MARK: - Menus, plugins and utilities
+
+XPLMMenuID XPLMFindAircraftMenu(void) {
+    static int menu;
+    return &menu;
+}
+
+int XPLMAppendMenuItemWithCommand(XPLMMenuID menu, const char *name, XPLMCommandRef cmd) {
+    UNUSED(menu);
+    UNUSED(name);
+    UNUSED(cmd);
+    return host.menu_items++;
+}
+
+void XPLMRemoveMenuItem(XPLMMenuID menu, int idx) {
+    UNUSED(menu);
+    UNUSED(idx);
+}
+
+XPLMPluginID XPLMGetMyID(void) {
+    return HOST_PLUGIN_ID;
+}
+
+XPLMPluginID XPLMFindPluginBySignature(const char *sig) {
+    UNUSED(sig);
+    return XPLM_NO_PLUGIN_ID;
+}
+
+void XPLMGetPluginInfo(XPLMPluginID id, char *name, char *path, char *sig, char *desc) {
+    UNUSED(id);
+    if(name)
+        strcpy(name, "");
+    if(path)
+        strcpy(path, host.plugin_path);
+    if(sig)
+        strcpy(sig, "");
+    if(desc)
+        strcpy(desc, "");
+}
+
+void XPLMSendMessageToPlugin(XPLMPluginID id, int msg, void *param) {
+    UNUSED(id);
+    UNUSED(msg);
+    UNUSED(param);
+}
+
+void XPLMEnableFeature(const char *feature, int enable) {
+    UNUSED(feature);
+    UNUSED(enable);
+}
+
+void XPLMGetNthAircraftModel(int idx, char *file, char *path) {
+    UNUSED(idx);
+    strcpy(file, "host.acf");
+    snprintf(path, 512, "%s%chost.acf", host.xplane_dir, DIR_SEP);
+}
+
+void XPLMGetSystemPath(char *path) {
+    snprintf(path, 512, "%s%c", host.xplane_dir, DIR_SEP);
+}
+
+void XPLMDebugString(const char *str) {
+    fputs(str, stderr);
+}
+
+// MARK: - Host side
+
+void host_init(const char *plugin_path, const char *xplane_dir) {
+    memset(&host, 0, sizeof(host));
+    snprintf(host.plugin_path, sizeof(host.plugin_path), "%s", plugin_path);
+    snprintf(host.xplane_dir, sizeof(host.xplane_dir), "%s", xplane_dir);
+    host.bus_ratio = 1.f;
+
+    host.dr_time = XPLMFindDataRef("sim/time/total_running_time_sec");
+    host.dr_fbo = XPLMFindDataRef("sim/graphics/view/current_gl_fbo");
+    host.dr_viewport = XPLMFindDataRef("sim/graphics/view/viewport");
+    host.dr_proj = XPLMFindDataRef("sim/graphics/view/projection_matrix");
+    host.dr_mv = XPLMFindDataRef("sim/graphics/view/modelview_matrix");
+
+    // A plane parked with its avionics on.
+    XPLMSetDatai(XPLMFindDataRef("sim/cockpit2/switches/avionics_power_on"), 1);
+    XPLMSetDataf(XPLMFindDataRef("sim/cockpit2/EFIS/map_range_nm"), 20.f);
+    XPLMSetDataf(XPLMFindDataRef("sim/cockpit2/EFIS/map_range_nm_copilot"), 20.f);
+}
+
+void host_fini(void) {
+    while(host.device_count)
+        XPLMDestroyAvionics(host.devices[0]);
+    for(unsigned i = 0; i < host.dataref_count; ++i) {
+        free(host.datarefs[i]->name);
+        free(host.datarefs[i]);
+    }
+    for(unsigned i = 0; i < host.command_count; ++i) {
+        free(host.commands[i]->name);
+        free(host.commands[i]);
+    }
+    memset(&host, 0, sizeof(host));
+}
+
+void host_set_radar_tex(unsigned tex) {
+    host.radar_tex = tex;
+}
+
+void host_set_bus_ratio(float ratio) {
+    host.bus_ratio = ratio;
+}
+
+void host_frame(float dt) {
+    host.time += dt;
+    host.cycle += 1;
+    host.dr_time->value = host.time;
+
+    // Callbacks can register and unregister flight loops, so they're found again each time.
+    for(unsigned i = 0; i < host.floop_count; ++i) {
+        host_floop_t *floop = &host.floops[i];
+        if(floop->interval == 0.f)
+            continue;
+        if(floop->interval > 0.f ? host.time < floop->next_time : host.cycle < floop->next_cycle)
+            continue;
+
+        XPLMFlightLoop_f callback = floop->callback;
+        void *refcon = floop->refcon;
+        float elapsed = host.time - floop->last_time;
+        floop->last_time = host.time;
+        float next = callback(elapsed, dt, ++floop->counter, refcon);
+
+        if(i < host.floop_count && host.floops[i].callback == callback)
+            floop_schedule(&host.floops[i], next);
+    }
+}
+
+static void host_ortho(float w, float h, float *m) {
+    memset(m, 0, 16 * sizeof(float));
+    m[0] = 2.f / w;
+    m[5] = 2.f / h;
+    m[10] = -1.f;
+    m[12] = -1.f;
+    m[13] = -1.f;
+    m[15] = 1.f;
+}
+
+// Points the view datarefs at the framebuffer X-Plane would be drawing into, with pixel
+// coordinates from its bottom left corner.
+static void host_bind(GLuint fbo, int w, int h) {
+    static const float identity[16] = {1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1};
+    int viewport[4] = {0, 0, w, h};
+    glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+    glViewport(0, 0, w, h);
+    host.dr_fbo->value = fbo;
+    memcpy(host.dr_viewport->ivalues, viewport, sizeof(viewport));
+    host_ortho(w, h, host.dr_proj->fvalues);
+    memcpy(host.dr_mv->fvalues, identity, sizeof(identity));
+}
+
+void host_draw(bool bezel) {
+    for(unsigned i = 0; i < host.device_count; ++i) {
+        host_device_t *dev = host.devices[i];
+        const XPLMCreateAvionics_t *desc = &dev->desc;
+
+        if(desc->drawCallback) {
+            host_bind(dev->screen_fbo, desc->screenWidth, desc->screenHeight);
+            desc->drawCallback(desc->refcon);
+        }
+        if(bezel && desc->bezelDrawCallback) {
+            host_bind(dev->bezel_fbo, desc->bezelWidth, desc->bezelHeight);
+            glClearColor(0, 0, 0, 0);
+            glClear(GL_COLOR_BUFFER_BIT);
+            desc->bezelDrawCallback(1.f, 1.f, 1.f, desc->refcon);
+        }
+        if(desc->brightnessCallback)
+            desc->brightnessCallback(dev->rheo, 1.f, host.bus_ratio, desc->refcon);
+    }
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+unsigned host_device_count(void) {
+    return host.device_count;
+}
+
+uint8_t *host_read_screen(unsigned idx, unsigned *w, unsigned *h) {
+    if(idx >= host.device_count)
+        return NULL;
+    const host_device_t *dev = host.devices[idx];
+    *w = dev->desc.screenWidth;
+    *h = dev->desc.screenHeight;
+
+    uint8_t *pixels = safe_malloc(*w * *h * 4);
+    glBindFramebuffer(GL_FRAMEBUFFER, dev->screen_fbo);
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glReadPixels(0, 0, *w, *h, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    return pixels;
+}